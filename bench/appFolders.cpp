@@ -0,0 +1,27 @@
+#include "bench.hpp"
+#include "../sago/app_folders.h"
+#include "../sago/platform_folders.h"
+#include <string>
+
+int main(int argc, char* argv[]) {
+	benchInit(argc, argv);
+	bench("AppFolders construction", 100000, []() {
+		sago::AppFolders app("Vendor", "App");
+		benchSink += app.config().size();
+	});
+	sago::AppFolders app("Vendor", "App");
+	const std::string config = sago::getConfigHome();
+	bench("getConfigHome() + concatenation", 1000000, []() {
+		std::string path = sago::getConfigHome() + "/Vendor/App/" + "settings.ini";
+		benchSink += path.size();
+	});
+	bench("cached string + concatenation", 1000000, [&config]() {
+		std::string path = config + "/Vendor/App/" + "settings.ini";
+		benchSink += path.size();
+	});
+	bench("AppFolders::join", 1000000, [&app]() {
+		std::string path = app.join(sago::BaseDir::Config, "settings.ini");
+		benchSink += path.size();
+	});
+	return 0;
+}
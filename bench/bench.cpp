@@ -0,0 +1,35 @@
+#include "bench.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+volatile std::size_t benchSink = 0;
+
+static bool benchJson = false;
+
+void benchInit(int argc, char* argv[]) {
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--json") == 0) {
+			benchJson = true;
+		}
+	}
+}
+
+void benchReport(const char* name, unsigned threads, long iterations, double nsPerOp) {
+	if (benchJson) {
+		std::printf("{\"name\": \"%s\", \"threads\": %u, \"iterations\": %ld, \"ns_per_op\": %.1f}\n", name, threads, iterations, nsPerOp);
+	}
+	else {
+		std::printf("%-50s %3u threads %10ld iterations %12.1f ns/op\n", name, threads, iterations, nsPerOp);
+	}
+	std::fflush(stdout);
+}
+
+void benchSkip(const char* name, const char* reason) {
+	if (benchJson) {
+		std::printf("{\"name\": \"%s\", \"skipped\": \"%s\"}\n", name, reason);
+	}
+	else {
+		std::printf("%-50s skipped: %s\n", name, reason);
+	}
+}
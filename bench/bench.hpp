@@ -0,0 +1,67 @@
+#ifndef SAGO_BENCH_HPP
+#define SAGO_BENCH_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Results are added here so the compiler cannot remove the benchmarked calls
+extern volatile std::size_t benchSink;
+
+// Reads the command line. "--json" prints every result as one JSON object per line so runs can be diffed.
+void benchInit(int argc, char* argv[]);
+
+// Prints one result in the format selected by benchInit()
+void benchReport(const char* name, unsigned threads, long iterations, double nsPerOp);
+
+// Prints a benchmark that could not run in this environment
+void benchSkip(const char* name, const char* reason);
+
+// Calls f the given number of times and reports the average time per call
+template <class F>
+double bench(const char* name, long iterations, F f) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (long i = 0; i < iterations; ++i) {
+		f();
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	double nsPerOp = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+	benchReport(name, 1, iterations, nsPerOp);
+	return nsPerOp;
+}
+
+// Calls f the given number of times on each of the threads at the same time.
+// The reported time is wall time divided by the iterations per thread, so it stays flat if the code scales linearly.
+template <class F>
+double benchThreads(const char* name, unsigned threads, long iterations, F f) {
+	std::atomic<unsigned> ready(0);
+	std::atomic<bool> go(false);
+	std::vector<std::thread> workers;
+	for (unsigned t = 0; t < threads; ++t) {
+		workers.push_back(std::thread([&]() {
+			++ready;
+			while (!go.load()) {
+				std::this_thread::yield();
+			}
+			for (long i = 0; i < iterations; ++i) {
+				f();
+			}
+		}));
+	}
+	while (ready.load() < threads) {
+		std::this_thread::yield();
+	}
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	go = true;
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	double nsPerOp = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+	benchReport(name, threads, iterations, nsPerOp);
+	return nsPerOp;
+}
+
+#endif
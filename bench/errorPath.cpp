@@ -0,0 +1,60 @@
+#include "bench.hpp"
+#include "../sago/platform_folders.h"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+// Compares the cost of a failed lookup through the error code API and through exceptions
+static void benchFailure(const char* what) {
+	std::string name = std::string("getConfigHome ") + what + " error_code";
+	bench(name.c_str(), 200000, []() {
+		std::error_code ec;
+		benchSink += sago::getConfigHome(ec).size() + ec.value();
+	});
+	name = std::string("getConfigHome ") + what + " exception";
+	bench(name.c_str(), 200000, []() {
+		try {
+			benchSink += sago::getConfigHome().size();
+		}
+		catch (const std::runtime_error& e) {
+			benchSink += e.what()[0];
+		}
+	});
+	name = std::string("getDocumentsFolder ") + what + " error_code";
+	bench(name.c_str(), 200000, []() {
+		std::error_code ec;
+		benchSink += sago::getDocumentsFolder(ec).size() + ec.value();
+	});
+	name = std::string("getDocumentsFolder ") + what + " exception";
+	bench(name.c_str(), 200000, []() {
+		try {
+			benchSink += sago::getDocumentsFolder().size();
+		}
+		catch (const std::runtime_error& e) {
+			benchSink += e.what()[0];
+		}
+	});
+}
+#endif
+
+int main(int argc, char* argv[]) {
+	benchInit(argc, argv);
+#if !defined(_WIN32) && !defined(__APPLE__)
+	sago::Environment env;
+	env.setUid(4242);
+	env.set(sago::Environment::Home, "/home/bench");
+	env.set(sago::Environment::XdgConfigHome, "relative/config");
+	sago::setEnvironmentProvider([env]() { return env; });
+	benchFailure("relative XDG_CONFIG_HOME");
+	// For comparison: the same calls when nothing fails
+	env.set(sago::Environment::XdgConfigHome, "/home/bench/.config");
+	sago::setEnvironmentProvider([env]() { return env; });
+	benchFailure("success");
+	sago::setEnvironmentProvider(sago::EnvironmentProvider());
+#else
+	std::printf("The failure paths are only benchmarked on Linux\n");
+#endif
+	return 0;
+}
@@ -0,0 +1,68 @@
+#include "bench.hpp"
+#include "../sago/file_finder.h"
+#include "../sago/platform_folders.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+
+// What callers do without FileFinder: build every candidate path and stat it
+static std::string naiveFind(const std::string& relativePath) {
+	std::vector<std::string> folders;
+	folders.push_back(sago::getDataHome());
+	sago::appendAdditionalDataDirectories(folders);
+	for (const std::string& folder : folders) {
+		std::string candidate = folder + "/" + relativePath;
+		struct stat st;
+		if (stat(candidate.c_str(), &st) == 0) {
+			return candidate;
+		}
+	}
+	return std::string();
+}
+#endif
+
+int main(int argc, char* argv[]) {
+	benchInit(argc, argv);
+#ifndef _WIN32
+	// Uses the real search path. Most systems have this in /usr/share.
+	const std::string hit = "applications";
+	const std::string miss = "platform_folders_bench/does_not_exist";
+	sago::FileFinder finder(sago::SearchPath::Data);
+	bench("naive find hit", 100000, [&]() {
+		benchSink += naiveFind(hit).size();
+	});
+	bench("FileFinder::find hit", 100000, [&]() {
+		benchSink += finder.find(hit).size();
+	});
+	bench("naive find miss", 100000, [&]() {
+		benchSink += naiveFind(miss).size();
+	});
+	bench("FileFinder::find miss", 100000, [&]() {
+		benchSink += finder.find(miss).size();
+	});
+	sago::FileFinder uncached(sago::SearchPath::Data, 0);
+	bench("FileFinder::find miss without negative cache", 100000, [&]() {
+		benchSink += uncached.find(miss).size();
+	});
+	std::vector<std::string> names;
+	for (int i = 0; i < 64; ++i) {
+		names.push_back("platform_folders_bench/file" + std::to_string(i));
+	}
+	std::vector<std::string> results;
+	bench("FileFinder::findMany 64 names without negative cache", 10000, [&]() {
+		uncached.findMany(names, results);
+		benchSink += results.size();
+	});
+	bench("FileFinder::find 64 names without negative cache", 10000, [&]() {
+		for (const std::string& name : names) {
+			benchSink += uncached.find(name).size();
+		}
+	});
+#else
+	std::printf("FileFinder is not available on Windows\n");
+#endif
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include "bench.hpp"
+#include "../sago/platform_folders.h"
+#include <cstdio>
+#include <string>
+
+#ifndef _WIN32
+#include <stdlib.h>
+#include <unistd.h>
+
+static void benchGetHome(const char* path) {
+	std::string name = std::string("getHome ") + path + " cold";
+	bench(name.c_str(), 1000, []() {
+		sago::invalidateFolderCache();
+		benchSink += sago::internal::getHome().size();
+	});
+	name = std::string("getHome ") + path + " warm";
+	bench(name.c_str(), 1000000, []() {
+		benchSink += sago::internal::getHome().size();
+	});
+	name = std::string("getDataHome(buffer) ") + path;
+	bench(name.c_str(), 1000000, []() {
+		char buffer[4096];
+		std::error_code ec;
+		benchSink += sago::getDataHome(buffer, sizeof(buffer), ec);
+	});
+}
+#endif
+
+int main(int argc, char* argv[]) {
+	benchInit(argc, argv);
+#ifndef _WIN32
+	const char* home = getenv("HOME");
+	std::string savedHome = home ? home : "";
+	if (getuid() != 0) {
+		setenv("HOME", "/home/bench", 1);
+		sago::invalidateFolderCache();
+		benchGetHome("env");
+	}
+	else {
+		benchSkip("getHome env", "HOME is ignored when running as root");
+	}
+	unsetenv("HOME");
+	sago::invalidateFolderCache();
+	benchGetHome("passwd");
+	if (home) {
+		setenv("HOME", savedHome.c_str(), 1);
+	}
+#else
+	std::printf("getHome is not used on Windows\n");
+#endif
+	return 0;
+}
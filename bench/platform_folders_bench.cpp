@@ -0,0 +1,211 @@
+#include "bench.hpp"
+#include "../sago/platform_folders.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+// Runs every resolution path of the library. Use --json and diff the output between versions.
+// --threads=N sets the highest thread count. The default is the number of hardware threads.
+
+typedef std::string (*FolderFunction)();
+
+struct NamedFunction {
+	const char* name;
+	FolderFunction function;
+};
+
+static const NamedFunction freeFunctions[] = {
+	{ "getDataHome", sago::getDataHome },
+	{ "getConfigHome", sago::getConfigHome },
+	{ "getCacheDir", sago::getCacheDir },
+	{ "getStateDir", sago::getStateDir },
+	{ "getDesktopFolder", sago::getDesktopFolder },
+	{ "getDocumentsFolder", sago::getDocumentsFolder },
+	{ "getDownloadFolder", sago::getDownloadFolder },
+	{ "getPicturesFolder", sago::getPicturesFolder },
+	{ "getPublicFolder", sago::getPublicFolder },
+	{ "getMusicFolder", sago::getMusicFolder },
+	{ "getVideoFolder", sago::getVideoFolder },
+	{ "getSaveGamesFolder1", sago::getSaveGamesFolder1 },
+	{ "getSaveGamesFolder2", sago::getSaveGamesFolder2 },
+};
+
+static void benchResolution(const std::string& suffix) {
+	bench(("PlatformFolders construction cold" + suffix).c_str(), 2000, []() {
+		sago::invalidateFolderCache();
+		sago::PlatformFolders pf;
+		benchSink += pf.getDocumentsFolder().size();
+	});
+	bench(("PlatformFolders construction warm" + suffix).c_str(), 2000, []() {
+		sago::PlatformFolders pf;
+		benchSink += pf.getDocumentsFolder().size();
+	});
+	// Construction alone does not resolve anything
+	bench(("PlatformFolders construction only" + suffix).c_str(), 200000, []() {
+		sago::PlatformFolders pf;
+		benchSink += pf.getSaveGamesFolder1().size();
+	});
+	for (const NamedFunction& f : freeFunctions) {
+		FolderFunction function = f.function;
+		bench((std::string(f.name) + " cold" + suffix).c_str(), 2000, [function]() {
+			sago::invalidateFolderCache();
+			benchSink += function().size();
+		});
+		bench((std::string(f.name) + " warm" + suffix).c_str(), 200000, [function]() {
+			benchSink += function().size();
+		});
+	}
+	bench(("get<Folder::Music> cold" + suffix).c_str(), 2000, []() {
+		sago::invalidateFolderCache();
+		benchSink += sago::get<sago::Folder::Music>().size();
+	});
+	// No copy, compare with getMusicFolder warm
+	bench(("get<Folder::Music> warm" + suffix).c_str(), 200000, []() {
+		benchSink += sago::get<sago::Folder::Music>().size();
+	});
+	bench(("appendAdditionalDataDirectories" + suffix).c_str(), 200000, []() {
+		std::vector<std::string> folders;
+		sago::appendAdditionalDataDirectories(folders);
+		benchSink += folders.size();
+	});
+	bench(("appendAdditionalConfigDirectories" + suffix).c_str(), 200000, []() {
+		std::vector<std::string> folders;
+		sago::appendAdditionalConfigDirectories(folders);
+		benchSink += folders.size();
+	});
+#ifndef _WIN32
+	bench(("getHome cold" + suffix).c_str(), 2000, []() {
+		sago::invalidateFolderCache();
+		benchSink += sago::internal::getHome().size();
+	});
+	bench(("getHome warm" + suffix).c_str(), 200000, []() {
+		benchSink += sago::internal::getHome().size();
+	});
+#endif
+}
+
+static void benchThreadScaling(unsigned maxThreads) {
+	sago::PlatformFolders shared;
+	// Powers of two and finally maxThreads itself
+	std::vector<unsigned> threadCounts;
+	for (unsigned threads = 1; threads < maxThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+	for (unsigned threads : threadCounts) {
+		benchThreads("getDocumentsFolder", threads, 100000, []() {
+			benchSink += sago::getDocumentsFolder().size();
+		});
+		benchThreads("getFolder(buffer)", threads, 100000, []() {
+			char buffer[4096];
+			std::error_code ec;
+			benchSink += sago::getFolder(sago::Folder::Music, buffer, sizeof(buffer), ec);
+		});
+		benchThreads("PlatformFolders::getFolder shared", threads, 100000, [&shared]() {
+			benchSink += shared.getFolder(sago::Folder::Pictures).size();
+		});
+		benchThreads("getDataHome", threads, 100000, []() {
+			benchSink += sago::getDataHome().size();
+		});
+	}
+}
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+static void benchXdgInternals(const std::string& configHome) {
+	const char* defaultDataDirs = "/usr/local/share/:/usr/share/";
+	bench("appendExtraFoldersTokenizer default", 200000, [defaultDataDirs]() {
+		std::vector<std::string> folders;
+		sago::internal::appendExtraFoldersTokenizer("XDG_DATA_DIRS", defaultDataDirs, folders);
+		benchSink += folders.size();
+	});
+	std::string longDataDirs;
+	for (int i = 0; i < 500; ++i) {
+		longDataDirs += "/nix/store/" + std::to_string(i % 100) + "-package/share/:";
+	}
+	bench("appendExtraFoldersTokenizer 500 entries dedup", 2000, [&longDataDirs]() {
+		std::vector<std::string> folders;
+		sago::internal::appendExtraFoldersTokenizer("XDG_DATA_DIRS", longDataDirs.c_str(), folders, sago::FolderListNormalizeTrailingSlash | sago::FolderListRemoveDuplicates);
+		benchSink += folders.size();
+	});
+	std::string userDirs = configHome + "/user-dirs.dirs";
+	bench("parseUserDirsFile typical", 100000, [&userDirs]() {
+		sago::internal::parseUserDirsFile(userDirs, [](const char*, std::size_t keyLength, std::string& value, bool) {
+			benchSink += keyLength + value.size();
+		});
+	});
+}
+#endif
+
+int main(int argc, char* argv[]) {
+	benchInit(argc, argv);
+	unsigned maxThreads = std::thread::hardware_concurrency();
+	for (int i = 1; i < argc; ++i) {
+		if (std::strncmp(argv[i], "--threads=", 10) == 0) {
+			maxThreads = static_cast<unsigned>(std::atoi(argv[i] + 10));
+		}
+	}
+	if (maxThreads == 0) {
+		maxThreads = 1;
+	}
+#if !defined(_WIN32) && !defined(__APPLE__)
+	// Use a known user-dirs.dirs so the numbers do not depend on the machine's configuration
+	char tmpl[] = "/tmp/sago_bench_XXXXXX";
+	const char* configHome = mkdtemp(tmpl);
+	if (!configHome) {
+		std::perror("mkdtemp");
+		return EXIT_FAILURE;
+	}
+	std::string userDirs = std::string(configHome) + "/user-dirs.dirs";
+	{
+		std::ofstream out(userDirs.c_str());
+		out << "# This file is written by xdg-user-dirs-update\n"
+			"XDG_DESKTOP_DIR=\"$HOME/Desktop\"\n"
+			"XDG_DOWNLOAD_DIR=\"$HOME/Downloads\"\n"
+			"XDG_TEMPLATES_DIR=\"$HOME/Templates\"\n"
+			"XDG_PUBLICSHARE_DIR=\"$HOME/Public\"\n"
+			"XDG_DOCUMENTS_DIR=\"$HOME/Documents\"\n"
+			"XDG_MUSIC_DIR=\"$HOME/Music\"\n"
+			"XDG_PICTURES_DIR=\"$HOME/Pictures\"\n"
+			"XDG_VIDEOS_DIR=\"$HOME/Videos\"\n";
+	}
+#else
+	const char* configHome = nullptr;
+#endif
+#ifndef _WIN32
+	// The environment comes from a provider so the process environment is neither read nor modified
+	sago::Environment env;
+	if (configHome) {
+		env.set(sago::Environment::XdgConfigHome, configHome);
+	}
+	env.set(sago::Environment::Home, "/home/bench");
+	// Any uid but root respects HOME
+	env.setUid(getuid() != 0 ? getuid() : 1000);
+	sago::setEnvironmentProvider([env]() { return env; });
+	benchResolution(" (home from env)");
+	env.unset(sago::Environment::Home);
+	env.setUid(getuid());
+	sago::setEnvironmentProvider([env]() { return env; });
+	benchResolution(" (home from passwd)");
+#else
+	benchResolution("");
+#endif
+	benchThreadScaling(maxThreads);
+#ifndef _WIN32
+	sago::setEnvironmentProvider(sago::EnvironmentProvider());
+#endif
+#if !defined(_WIN32) && !defined(__APPLE__)
+	benchXdgInternals(configHome);
+	std::remove(userDirs.c_str());
+	rmdir(configHome);
+#endif
+	return 0;
+}
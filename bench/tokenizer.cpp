@@ -0,0 +1,64 @@
+#include "bench.hpp"
+#include "../sago/platform_folders.h"
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+// The original std::stringstream based tokenizer. Kept here as a reference.
+static void legacyTokenizer(const char* envName, const char* envValue, std::vector<std::string>& folders) {
+	std::stringstream ss(envValue);
+	std::string value;
+	while (std::getline(ss, value, ':')) {
+		if (value[0] == '/') {
+			folders.push_back(value);
+		}
+		else {
+			std::cerr << "Skipping path \"" << value << "\" in \"" << envName << "\" because it does not start with a \"/\"\n";
+		}
+	}
+}
+
+// Looks like XDG_DATA_DIRS in a Nix or Flatpak environment where the same few folders are repeated
+static std::string makeValue(int entries) {
+	std::string value;
+	for (int i = 0; i < entries; ++i) {
+		if (i) {
+			value += ':';
+		}
+		value += "/nix/store/" + std::to_string(i % (entries / 4 + 1)) + "-package/share/";
+	}
+	return value;
+}
+#endif
+
+int main(int argc, char* argv[]) {
+	benchInit(argc, argv);
+#if !defined(_WIN32) && !defined(__APPLE__)
+	const int sizes[] = { 2, 50, 500 };
+	for (int entries : sizes) {
+		std::string value = makeValue(entries);
+		std::string suffix = " " + std::to_string(entries) + " entries";
+		bench(("legacy tokenizer" + suffix).c_str(), 200000 / entries, [&]() {
+			std::vector<std::string> folders;
+			legacyTokenizer("XDG_DATA_DIRS", value.c_str(), folders);
+			benchSink += folders.size();
+		});
+		bench(("appendExtraFoldersTokenizer" + suffix).c_str(), 200000 / entries, [&]() {
+			std::vector<std::string> folders;
+			sago::internal::appendExtraFoldersTokenizer("XDG_DATA_DIRS", value.c_str(), folders);
+			benchSink += folders.size();
+		});
+		bench(("appendExtraFoldersTokenizer dedup" + suffix).c_str(), 200000 / entries, [&]() {
+			std::vector<std::string> folders;
+			sago::internal::appendExtraFoldersTokenizer("XDG_DATA_DIRS", value.c_str(), folders, sago::FolderListNormalizeTrailingSlash | sago::FolderListRemoveDuplicates);
+			benchSink += folders.size();
+		});
+	}
+#else
+	std::printf("XDG_DATA_DIRS is only used with XDG\n");
+#endif
+	return 0;
+}
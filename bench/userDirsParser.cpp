@@ -0,0 +1,107 @@
+#include "bench.hpp"
+#include "../sago/platform_folders.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <stdlib.h>
+#include <unistd.h>
+
+// The original std::getline based parser. Kept here as a reference.
+static void legacyParse(const std::string& filename, std::map<std::string, std::string>& folders) {
+	std::ifstream infile(filename.c_str());
+	std::string line;
+	while (std::getline(infile, line)) {
+		if (line.length() == 0 || line.at(0) == '#' || line.substr(0, 4) != "XDG_" || line.find("_DIR") == std::string::npos) {
+			continue;
+		}
+		try {
+			std::size_t splitPos = line.find('=');
+			std::string key = line.substr(0, splitPos);
+			std::size_t valueStart = line.find('"', splitPos);
+			std::size_t valueEnd = line.find('"', valueStart+1);
+			std::string value = line.substr(valueStart+1, valueEnd - valueStart - 1);
+			folders[key] = value;
+		}
+		catch (std::exception&  e) {
+			std::cerr << "WARNING: Failed to process \"" << line << "\" from \"" << filename << "\". Error: "<< e.what() << "\n";
+			continue;
+		}
+	}
+}
+
+static void parse(const std::string& filename, std::map<std::string, std::string>& folders) {
+	sago::internal::parseUserDirsFile(filename, [&](const char* key, std::size_t keyLength, std::string& value, bool) {
+		folders[std::string(key, keyLength)].swap(value);
+	});
+}
+
+static void writeFile(const std::string& filename, const std::string& content) {
+	std::ofstream out(filename.c_str());
+	out << content;
+}
+
+static void compare(const char* name, const std::string& filename, long iterations) {
+	std::string legacyName = std::string("legacy parser ") + name;
+	bench(legacyName.c_str(), iterations, [&]() {
+		std::map<std::string, std::string> folders;
+		legacyParse(filename, folders);
+		benchSink += folders.size();
+	});
+	std::string newName = std::string("parseUserDirsFile ") + name;
+	bench(newName.c_str(), iterations, [&]() {
+		std::map<std::string, std::string> folders;
+		parse(filename, folders);
+		benchSink += folders.size();
+	});
+}
+#endif
+
+int main(int argc, char* argv[]) {
+	benchInit(argc, argv);
+#if !defined(_WIN32) && !defined(__APPLE__)
+	char tmpl[] = "/tmp/sago_parser_bench_XXXXXX";
+	const char* dir = mkdtemp(tmpl);
+	if (!dir) {
+		std::perror("mkdtemp");
+		return 1;
+	}
+	const char* names[] = { "DESKTOP", "DOCUMENTS", "DOWNLOAD", "MUSIC", "PICTURES", "PUBLICSHARE", "TEMPLATES", "VIDEOS" };
+	std::string typical = "# This file is written by xdg-user-dirs-update\n";
+	for (const char* name : names) {
+		typical += std::string("XDG_") + name + "_DIR=\"$HOME/" + name + "\"\n";
+	}
+	std::string large;
+	std::string malformed;
+	for (int i = 0; i < 2000; ++i) {
+		large += "# A comment line that should be skipped quickly\n";
+		large += "XDG_GENERATED" + std::to_string(i) + "_DIR=\"$HOME/Generated folder " + std::to_string(i) + "\"\n";
+		large += std::string("XDG_") + names[i % 8] + "_DIR=\"/mnt/storage/" + std::to_string(i) + "\"\n";
+		malformed += "XDG_BROKEN" + std::to_string(i) + "_DIR=\"/unterminated\n";
+		malformed += "XDG_NOEQUALS" + std::to_string(i) + "_DIR \"/x\"\n";
+		malformed += "XDG_MUSIC_DIR=\"/ok" + std::to_string(i) + "\"\n";
+	}
+	std::string typicalFile = std::string(dir) + "/typical.dirs";
+	std::string largeFile = std::string(dir) + "/large.dirs";
+	std::string malformedFile = std::string(dir) + "/malformed.dirs";
+	writeFile(typicalFile, typical);
+	writeFile(largeFile, large);
+	writeFile(malformedFile, malformed);
+	// Warnings are discarded so the benchmark measures the parsing and not the terminal
+	std::streambuf* cerrBuffer = std::cerr.rdbuf(nullptr);
+	compare("typical", typicalFile, 20000);
+	compare("large (6000 lines)", largeFile, 200);
+	compare("malformed (6000 lines)", malformedFile, 200);
+	std::cerr.rdbuf(cerrBuffer);
+	std::remove(typicalFile.c_str());
+	std::remove(largeFile.c_str());
+	std::remove(malformedFile.c_str());
+	rmdir(dir);
+#else
+	std::printf("user-dirs.dirs is only used with XDG\n");
+#endif
+	return 0;
+}
@@ -28,23 +28,23 @@
 #include "sago/platform_folders.h"
 
 int main() {
-	std::cout << "Config: " << sago::getConfigHome() << "\n";
-	std::cout << "Data: " << sago::getDataHome() << "\n";
-	std::cout << "State: " << sago::getStateDir() << "\n";
-	std::cout << "Cache: " << sago::getCacheDir() << "\n";
-	std::cout << "Documents: " << sago::getDocumentsFolder() << "\n";
-	std::cout << "Desktop: " << sago::getDesktopFolder() << "\n";
-	std::cout << "Pictures: " << sago::getPicturesFolder() << "\n";
-	std::cout << "Public: " << sago::getPublicFolder() << "\n";
-	std::cout << "Music: " << sago::getMusicFolder() << "\n";
-	std::cout << "Video: " << sago::getVideoFolder() << "\n";
-	std::cout << "Download: " << sago::getDownloadFolder() << "\n";
-	std::cout << "Save Games 1: " << sago::getSaveGamesFolder1() << "\n";
-	std::cout << "Save Games 2: " << sago::getSaveGamesFolder2() << "\n";
-	std::vector<std::string> extraData;
-	sago::appendAdditionalDataDirectories(extraData);
-	for (size_t i=0; i < extraData.size(); ++i) {
-		std::cout << "Additional data " << i << ": " << extraData.at(i) << "\n";
+	sago::AllFolders folders;
+	sago::getAllFolders(folders);
+	std::cout << "Config: " << folders.configHome << "\n";
+	std::cout << "Data: " << folders.dataHome << "\n";
+	std::cout << "State: " << folders.stateDir << "\n";
+	std::cout << "Cache: " << folders.cacheDir << "\n";
+	std::cout << "Documents: " << folders.folder(sago::Folder::Documents) << "\n";
+	std::cout << "Desktop: " << folders.folder(sago::Folder::Desktop) << "\n";
+	std::cout << "Pictures: " << folders.folder(sago::Folder::Pictures) << "\n";
+	std::cout << "Public: " << folders.folder(sago::Folder::Public) << "\n";
+	std::cout << "Music: " << folders.folder(sago::Folder::Music) << "\n";
+	std::cout << "Video: " << folders.folder(sago::Folder::Videos) << "\n";
+	std::cout << "Download: " << folders.folder(sago::Folder::Download) << "\n";
+	std::cout << "Save Games 1: " << folders.saveGamesFolder1 << "\n";
+	std::cout << "Save Games 2: " << folders.saveGamesFolder2 << "\n";
+	for (size_t i=0; i < folders.additionalDataDirectories.size(); ++i) {
+		std::cout << "Additional data " << i << ": " << folders.additionalDataDirectories.at(i) << "\n";
 	}
 	return 0;
 }
@@ -0,0 +1,140 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015-2016 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "app_folders.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace sago {
+
+#ifdef _WIN32
+static const char pathSeparator = '\\';
+#else
+static const char pathSeparator = '/';
+#endif
+
+bool operator==(const PathView& a, const PathView& b) {
+	return a.size() == b.size() && (a.size() == 0 || std::memcmp(a.data(), b.data(), a.size()) == 0);
+}
+
+bool operator!=(const PathView& a, const PathView& b) {
+	return !(a == b);
+}
+
+static void PlatformFoldersCheckName(const std::string& name, const char* what) {
+	if (name.find('/') != std::string::npos || name.find(pathSeparator) != std::string::npos) {
+		throw std::invalid_argument(std::string(what) + " \"" + name + "\" must not contain a path separator");
+	}
+	if (name == "." || name == "..") {
+		// Would point at the base folder or its parent instead of a subfolder
+		throw std::invalid_argument(std::string(what) + " must not be \"" + name + "\"");
+	}
+}
+
+AppFolders::AppFolders(const std::string& vendor, const std::string& app) {
+	if (app.empty()) {
+		throw std::invalid_argument("The app name must not be empty");
+	}
+	PlatformFoldersCheckName(vendor, "The vendor name");
+	PlatformFoldersCheckName(app, "The app name");
+	std::string suffix;
+	if (!vendor.empty()) {
+		suffix += pathSeparator;
+		suffix += vendor;
+	}
+	suffix += pathSeparator;
+	suffix += app;
+	std::string bases[baseDirCount];
+	std::size_t total = 0;
+	for (std::size_t i = 0; i < baseDirCount; ++i) {
+		bases[i] = getBaseDir(static_cast<BaseDir>(i));
+		total += bases[i].size() + suffix.size();
+	}
+	buffer.reserve(total);
+	for (std::size_t i = 0; i < baseDirCount; ++i) {
+		std::size_t shared = i;
+		for (std::size_t j = 0; j < i; ++j) {
+			if (bases[j] == bases[i]) {
+				shared = j;
+				break;
+			}
+		}
+		if (shared != i) {
+			offsets[i] = offsets[shared];
+			lengths[i] = lengths[shared];
+			continue;
+		}
+		offsets[i] = buffer.size();
+		buffer += bases[i];
+		buffer += suffix;
+		lengths[i] = buffer.size() - offsets[i];
+	}
+}
+
+PathView AppFolders::get(BaseDir dir) const {
+	std::size_t i = static_cast<std::size_t>(dir);
+	return PathView(buffer.data() + offsets[i], lengths[i]);
+}
+
+bool AppFolders::sameFolder(BaseDir a, BaseDir b) const {
+	return offsets[static_cast<std::size_t>(a)] == offsets[static_cast<std::size_t>(b)];
+}
+
+std::vector<PathView> AppFolders::uniqueFolders() const {
+	std::vector<PathView> result;
+	for (std::size_t i = 0; i < baseDirCount; ++i) {
+		bool seen = false;
+		for (std::size_t j = 0; j < i; ++j) {
+			seen = seen || offsets[j] == offsets[i];
+		}
+		if (!seen) {
+			result.push_back(get(static_cast<BaseDir>(i)));
+		}
+	}
+	return result;
+}
+
+std::string AppFolders::join(BaseDir dir, const char* relativePath, std::size_t relativeLength) const {
+	PathView folder = get(dir);
+	std::string result;
+	result.reserve(folder.size() + 1 + relativeLength);
+	result.append(folder.data(), folder.size());
+	result += pathSeparator;
+	result.append(relativePath, relativeLength);
+	return result;
+}
+
+std::string AppFolders::join(BaseDir dir, const char* relativePath) const {
+	return join(dir, relativePath, std::strlen(relativePath));
+}
+
+std::string AppFolders::join(BaseDir dir, const std::string& relativePath) const {
+	return join(dir, relativePath.data(), relativePath.size());
+}
+
+}  // namespace sago
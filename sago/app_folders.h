@@ -0,0 +1,129 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SAGO_APP_FOLDERS_H
+#define SAGO_APP_FOLDERS_H
+
+#include "platform_folders.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace sago {
+
+/**
+ * A non owning reference to a path. Not null terminated.
+ */
+class PathView {
+public:
+	PathView() : begin(nullptr), length(0) {}
+	PathView(const char* data, std::size_t size) : begin(data), length(size) {}
+	const char* data() const {
+		return begin;
+	}
+	std::size_t size() const {
+		return length;
+	}
+	bool empty() const {
+		return length == 0;
+	}
+	std::string str() const {
+		return std::string(begin, length);
+	}
+private:
+	const char* begin;
+	std::size_t length;
+};
+
+bool operator==(const PathView& a, const PathView& b);
+bool operator!=(const PathView& a, const PathView& b);
+
+/**
+ * The base folders with the program's own subfolder appended, resolved once.
+ * The result is "<base>/<vendor>/<app>". The vendor is left out if it is empty.
+ * Base folders that are the same on this platform, like data and config on Windows, are stored once
+ * and sameFolder() tells if two of them are shared.
+ * @code{.cpp}
+ * sago::AppFolders app("MyCompany", "MyProgram");
+ * std::string settings = app.join(sago::BaseDir::Config, "settings.ini");
+ * @endcode
+ */
+class AppFolders {
+public:
+	/**
+	 * Resolves the folders. The folders are not created.
+	 * @param vendor May be empty
+	 * @param app The program name. Must not be empty
+	 * @throws std::invalid_argument if app is empty or a name is "." or ".." or contains a path separator
+	 */
+	AppFolders(const std::string& vendor, const std::string& app);
+	/**
+	 * @return The folder. Valid for the lifetime of this object.
+	 */
+	PathView get(BaseDir dir) const;
+	PathView data() const {
+		return get(BaseDir::Data);
+	}
+	PathView config() const {
+		return get(BaseDir::Config);
+	}
+	PathView cache() const {
+		return get(BaseDir::Cache);
+	}
+	PathView state() const {
+		return get(BaseDir::State);
+	}
+	/**
+	 * @return true if the two folders are the same on this platform
+	 */
+	bool sameFolder(BaseDir a, BaseDir b) const;
+	/**
+	 * The distinct folders. Use this to create them without special cases for each platform.
+	 * @return Each folder once, in the order of BaseDir
+	 */
+	std::vector<PathView> uniqueFolders() const;
+	/**
+	 * Builds the path of a file in one of the folders with a single allocation.
+	 * @param dir The folder
+	 * @param relativePath Appended after a path separator
+	 * @return The full path
+	 */
+	std::string join(BaseDir dir, const char* relativePath) const;
+	std::string join(BaseDir dir, const std::string& relativePath) const;
+private:
+	static const std::size_t baseDirCount = static_cast<std::size_t>(BaseDir::State) + 1;
+	std::string join(BaseDir dir, const char* relativePath, std::size_t relativeLength) const;
+	// All distinct folders after each other
+	std::string buffer;
+	std::size_t offsets[baseDirCount];
+	std::size_t lengths[baseDirCount];
+};
+
+}  //namespace sago
+
+#endif  /* SAGO_APP_FOLDERS_H */
@@ -0,0 +1,329 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015-2016 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "atomic_writer.h"
+
+#ifndef _WIN32
+
+#include "ensure_folder.h"
+#include "internal_posix.h"
+#include <cerrno>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sago {
+
+using internal::throwErrno;
+using internal::writeAll;
+
+namespace {
+
+struct StagedFile {
+	std::string relativePath;
+	int dirFd;
+	std::string name;
+	int fd;
+	// Empty while an O_TMPFILE file has no name
+	std::string tmpName;
+};
+
+int syncData(int fd) {
+#ifdef __APPLE__
+	return fsync(fd);
+#else
+	return fdatasync(fd);
+#endif
+}
+
+/**
+ * True if path is relative and stays inside the folder: no empty, "." or ".." components.
+ */
+bool isContainedPath(const std::string& path) {
+	if (path.empty() || path[0] == '/') {
+		return false;
+	}
+	std::size_t start = 0;
+	while (start <= path.size()) {
+		std::size_t end = path.find('/', start);
+		if (end == std::string::npos) {
+			end = path.size();
+		}
+		std::size_t length = end - start;
+		if (length == 0 || (length == 1 && path[start] == '.') || (length == 2 && path.compare(start, 2, "..") == 0)) {
+			return false;
+		}
+		start = end + 1;
+	}
+	return true;
+}
+
+/**
+ * Gives the temporary file the permissions of the file it replaces. New files keep 0600.
+ */
+void keepMode(const StagedFile& file) {
+	struct stat st;
+	if (fstatat(file.dirFd, file.name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+		if (errno == ENOENT) {
+			return;
+		}
+		throwErrno("Failed to read the permissions of \"" + file.relativePath + "\"");
+	}
+	if (S_ISREG(st.st_mode) && fchmod(file.fd, st.st_mode & 07777) != 0) {
+		throwErrno("Failed to set the permissions of \"" + file.relativePath + "\"");
+	}
+}
+
+/**
+ * Syncs the folders so the renames in them are durable.
+ * @return false if a sync failed. errno is then set. The other folders are still synced.
+ */
+bool syncFolders(const std::set<int>& folders) {
+	bool ok = true;
+	int error = 0;
+	for (std::set<int>::const_iterator itr = folders.begin(); itr != folders.end(); ++itr) {
+		if (fsync(*itr) != 0 && ok) {
+			ok = false;
+			error = errno;
+		}
+	}
+	errno = error;
+	return ok;
+}
+
+void dropStaged(StagedFile& file) {
+	if (file.fd >= 0) {
+		close(file.fd);
+		file.fd = -1;
+	}
+	if (!file.tmpName.empty()) {
+		unlinkat(file.dirFd, file.tmpName.c_str(), 0);
+		file.tmpName.clear();
+	}
+}
+
+}  // namespace
+
+struct AtomicWriter::AtomicWriterData {
+	std::string folder;
+	// Parent folder relative to folder, "" for folder itself
+	std::map<std::string, int> dirs;
+	std::vector<StagedFile> staged;
+	unsigned counter;
+
+	AtomicWriterData() : counter(0) {}
+
+	~AtomicWriterData() {
+		discard();
+		for (std::map<std::string, int>::iterator itr = dirs.begin(); itr != dirs.end(); ++itr) {
+			close(itr->second);
+		}
+	}
+
+	void discard() {
+		for (std::size_t i = 0; i < staged.size(); ++i) {
+			dropStaged(staged[i]);
+		}
+		staged.clear();
+	}
+
+	int dirFd(const std::string& parent) {
+		std::map<std::string, int>::iterator itr = dirs.find(parent);
+		if (itr != dirs.end()) {
+			return itr->second;
+		}
+		std::string path = parent.empty() ? folder : ensureFolder(folder + "/" + parent);
+		// The folder must be opened for reading so it can be synced
+		int fd = internal::openReadableFolder(path.c_str());
+		if (fd < 0) {
+			throwErrno("Failed to open \"" + path + "\"");
+		}
+		dirs[parent] = fd;
+		return fd;
+	}
+
+	std::string nextTmpName(const std::string& name) {
+		char suffix[64];
+		std::snprintf(suffix, sizeof(suffix), ".tmp.%ld.%u", static_cast<long>(getpid()), counter++);
+		return "." + name + suffix;
+	}
+
+	void createTemporary(StagedFile& file) {
+#ifdef O_TMPFILE
+		file.fd = openat(file.dirFd, ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, 0600);
+		if (file.fd >= 0) {
+			return;
+		}
+		if (errno != EOPNOTSUPP && errno != EISDIR && errno != EINVAL) {
+			throwErrno("Failed to create a temporary file for \"" + file.relativePath + "\"");
+		}
+		// The file system does not support O_TMPFILE
+#endif
+		file.tmpName = nextTmpName(file.name);
+		file.fd = openat(file.dirFd, file.tmpName.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+		if (file.fd < 0) {
+			file.tmpName.clear();
+			throwErrno("Failed to create a temporary file for \"" + file.relativePath + "\"");
+		}
+	}
+
+	/**
+	 * Gives an O_TMPFILE file a name so it can be renamed over the target.
+	 * linkat() cannot replace an existing file itself.
+	 */
+	void linkTemporary(StagedFile& file) {
+		if (!file.tmpName.empty()) {
+			return;
+		}
+		std::string tmpName = nextTmpName(file.name);
+		char procPath[64];
+		std::snprintf(procPath, sizeof(procPath), "/proc/self/fd/%d", file.fd);
+		if (linkat(AT_FDCWD, procPath, file.dirFd, tmpName.c_str(), AT_SYMLINK_FOLLOW) != 0) {
+#ifdef AT_EMPTY_PATH
+			// Needs CAP_DAC_READ_SEARCH but works without /proc
+			if (linkat(file.fd, "", file.dirFd, tmpName.c_str(), AT_EMPTY_PATH) != 0)
+#endif
+			{
+				throwErrno("Failed to link the temporary file for \"" + file.relativePath + "\"");
+			}
+		}
+		file.tmpName = tmpName;
+	}
+};
+
+AtomicWriter::AtomicWriter(BaseDir dir, const std::string& subfolder) {
+	this->data = new AtomicWriter::AtomicWriterData();
+	try {
+		std::string base = getBaseDir(dir);
+		if (!subfolder.empty()) {
+			if (!isContainedPath(subfolder)) {
+				throw std::runtime_error("The subfolder \"" + subfolder + "\" must be relative and must not contain \"..\"");
+			}
+			base += "/" + subfolder;
+		}
+		data->folder = ensureFolder(base);
+		data->dirFd("");
+	}
+	catch (...) {
+		delete this->data;
+		throw;
+	}
+}
+
+AtomicWriter::~AtomicWriter() {
+	delete this->data;
+}
+
+void AtomicWriter::write(const std::string& relativePath, const std::string& contents) {
+	if (!isContainedPath(relativePath)) {
+		throw std::runtime_error("\"" + relativePath + "\" is not a relative file name inside the folder");
+	}
+	for (std::size_t i = 0; i < data->staged.size(); ++i) {
+		if (data->staged[i].relativePath == relativePath) {
+			dropStaged(data->staged[i]);
+			data->staged.erase(data->staged.begin() + i);
+			break;
+		}
+	}
+	StagedFile file;
+	file.relativePath = relativePath;
+	std::size_t slash = relativePath.rfind('/');
+	file.dirFd = data->dirFd(slash == std::string::npos ? std::string() : relativePath.substr(0, slash));
+	file.name = slash == std::string::npos ? relativePath : relativePath.substr(slash + 1);
+	file.fd = -1;
+	data->createTemporary(file);
+	if (!writeAll(file.fd, contents.data(), contents.size())) {
+		int error = errno;
+		dropStaged(file);
+		errno = error;
+		throwErrno("Failed to write the temporary file for \"" + relativePath + "\"");
+	}
+	data->staged.push_back(file);
+}
+
+void AtomicWriter::commit() {
+	std::vector<StagedFile>& staged = data->staged;
+	// First make all data durable and give every file a temporary name. Nothing has been replaced yet.
+	for (std::size_t i = 0; i < staged.size(); ++i) {
+		if (syncData(staged[i].fd) != 0) {
+			throwErrno("Failed to sync \"" + staged[i].relativePath + "\"");
+		}
+		keepMode(staged[i]);
+		data->linkTemporary(staged[i]);
+	}
+	std::set<int> touched;
+	std::size_t done = 0;
+	try {
+		for (; done < staged.size(); ++done) {
+			StagedFile& file = staged[done];
+			if (renameat(file.dirFd, file.tmpName.c_str(), file.dirFd, file.name.c_str()) != 0) {
+				throwErrno("Failed to replace \"" + file.relativePath + "\"");
+			}
+			file.tmpName.clear();
+			touched.insert(file.dirFd);
+		}
+	}
+	catch (...) {
+		for (std::size_t i = 0; i < done; ++i) {
+			dropStaged(staged[i]);
+		}
+		staged.erase(staged.begin(), staged.begin() + done);
+		// The files that were replaced stay replaced. Make that durable before reporting the failure.
+		syncFolders(touched);
+		throw;
+	}
+	for (std::size_t i = 0; i < staged.size(); ++i) {
+		dropStaged(staged[i]);
+	}
+	staged.clear();
+	// One sync per folder makes all the renames in it durable
+	if (!syncFolders(touched)) {
+		throwErrno("Failed to sync a folder in \"" + data->folder + "\"");
+	}
+}
+
+void AtomicWriter::discard() {
+	data->discard();
+}
+
+std::size_t AtomicWriter::pending() const {
+	return data->staged.size();
+}
+
+const std::string& AtomicWriter::folder() const {
+	return data->folder;
+}
+
+}  // namespace sago
+
+#endif
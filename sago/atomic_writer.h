@@ -0,0 +1,107 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SAGO_ATOMIC_WRITER_H
+#define SAGO_ATOMIC_WRITER_H
+
+#include "platform_folders.h"
+#include <cstddef>
+#include <string>
+
+namespace sago {
+
+#ifndef _WIN32
+
+/**
+ * Replaces files atomically. A reader sees either the old or the new contents, never a mix,
+ * also if the program or the machine crashes.
+ * Files are staged with write() and only replace the real files when commit() is called.
+ * Each file is written to a temporary file in the same folder, synced and renamed over the target.
+ * The folders are synced once per commit, not once per file.
+ * On Linux the temporary files are created with O_TMPFILE where the file system supports it,
+ * so nothing is left behind if the program dies before committing.
+ * @code{.cpp}
+ * sago::AtomicWriter writer(sago::BaseDir::Config, "my_program");
+ * writer.write("settings.ini", settings);
+ * writer.write("keys/bindings.ini", bindings);
+ * writer.commit();
+ * @endcode
+ * @note Every file is replaced atomically, but a crash during commit() can leave some files replaced and others not.
+ * @note Not available on Windows
+ */
+class AtomicWriter {
+public:
+	/**
+	 * @param dir The base folder, normally BaseDir::Config or BaseDir::State
+	 * @param subfolder Relative to the base folder. Created if it does not exist. May be empty.
+	 * @throws std::runtime_error if subfolder is absolute or has an empty, "." or ".." component
+	 */
+	explicit AtomicWriter(BaseDir dir, const std::string& subfolder = std::string());
+	/**
+	 * Discards everything that has not been committed.
+	 */
+	~AtomicWriter();
+	/**
+	 * Stages new contents for a file. The data is written to a temporary file right away.
+	 * Writing the same file again replaces what was staged before.
+	 * @param relativePath Relative to the folder. Missing parent folders are created.
+	 * @param contents The new contents
+	 * @throws std::runtime_error if the temporary file could not be written or relativePath is absolute
+	 * or has an empty, "." or ".." component
+	 */
+	void write(const std::string& relativePath, const std::string& contents);
+	/**
+	 * Replaces all staged files. A file that is replaced keeps its permissions. New files are created with 0600.
+	 * @throws std::runtime_error if a file could not be replaced. Files that were not replaced stay staged.
+	 * The files that were replaced before the failure are synced like after a successful commit.
+	 */
+	void commit();
+	/**
+	 * Throws away all staged files.
+	 */
+	void discard();
+	/**
+	 * @return The number of staged files
+	 */
+	std::size_t pending() const;
+	/**
+	 * @return The folder the relative paths are relative to
+	 */
+	const std::string& folder() const;
+private:
+	AtomicWriter(const AtomicWriter&) = delete;
+	AtomicWriter& operator=(const AtomicWriter&) = delete;
+	struct AtomicWriterData;
+	AtomicWriterData* data;
+};
+
+#endif
+
+}  //namespace sago
+
+#endif  /* SAGO_ATOMIC_WRITER_H */
@@ -0,0 +1,582 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015-2016 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "cache_store.h"
+
+#ifndef _WIN32
+
+#include "ensure_folder.h"
+#include "internal_posix.h"
+#include "platform_folders.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sago {
+
+using internal::throwErrno;
+using internal::writeAll;
+
+namespace {
+
+const char indexMagic[8] = { 'S', 'A', 'G', 'O', 'C', 'I', '0', '1' };
+const std::size_t shardCount = 256;
+// Access times are only written to the index if they are older than this
+const std::int64_t touchIntervalNs = 60LL * 1000 * 1000 * 1000;
+
+enum RecordOp : std::uint64_t {
+	RecordPut = 1,
+	RecordRemove = 2
+};
+
+/**
+ * One entry in the index journal. Native byte order, the cache never leaves the machine.
+ */
+struct IndexRecord {
+	std::uint64_t op;
+	std::uint64_t hash;
+	std::uint64_t size;
+	std::int64_t accessTime;
+};
+
+static_assert(sizeof(IndexRecord) == 32, "IndexRecord must not have padding");
+
+struct IndexEntry {
+	std::uint64_t size;
+	std::int64_t accessTime;
+};
+
+std::int64_t nowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::uint64_t keyHash(const std::string& key) {
+	std::uint64_t hash = 14695981039346656037ULL;
+	for (std::size_t i = 0; i < key.size(); ++i) {
+		hash ^= static_cast<unsigned char>(key[i]);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+void hexHash(std::uint64_t hash, char* out) {
+	static const char digits[] = "0123456789abcdef";
+	for (int i = 15; i >= 0; --i) {
+		out[i] = digits[hash & 0xf];
+		hash >>= 4;
+	}
+	out[16] = '\0';
+}
+
+bool parseHexHash(const char* name, std::uint64_t& hash) {
+	hash = 0;
+	for (int i = 0; i < 16; ++i) {
+		char c = name[i];
+		int digit;
+		if (c >= '0' && c <= '9') {
+			digit = c - '0';
+		}
+		else if (c >= 'a' && c <= 'f') {
+			digit = c - 'a' + 10;
+		}
+		else {
+			return false;
+		}
+		hash = (hash << 4) | static_cast<std::uint64_t>(digit);
+	}
+	return name[16] == '\0';
+}
+
+std::int64_t timespecNs(const struct timespec& ts) {
+	return static_cast<std::int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * Holds an flock() for the lifetime of the object
+ */
+class FileLock {
+public:
+	explicit FileLock(int fd) : fd(fd) {
+		while (flock(fd, LOCK_EX) != 0) {
+			if (errno != EINTR) {
+				throwErrno("Failed to lock the cache store");
+			}
+		}
+	}
+	~FileLock() {
+		flock(fd, LOCK_UN);
+	}
+private:
+	FileLock(const FileLock&) = delete;
+	FileLock& operator=(const FileLock&) = delete;
+	int fd;
+};
+
+typedef std::unordered_map<std::uint64_t, IndexEntry> IndexMap;
+
+/**
+ * Scans a range of shard folders. Runs on its own thread during a rebuild.
+ */
+void scanShards(int rootFd, std::size_t first, std::size_t last, IndexMap& found) {
+	for (std::size_t shard = first; shard < last; ++shard) {
+		char name[3];
+		std::snprintf(name, sizeof(name), "%02x", static_cast<unsigned>(shard));
+		int shardFd = openat(rootFd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (shardFd < 0) {
+			continue;
+		}
+		DIR* dir = fdopendir(shardFd);
+		if (!dir) {
+			close(shardFd);
+			continue;
+		}
+		while (struct dirent* entry = readdir(dir)) {
+			std::uint64_t hash;
+			if (std::strncmp(entry->d_name, ".tmp.", 5) == 0) {
+				// Left behind by a crashed writer. Writers hold the lock, just like the rebuild, so none is active.
+				unlinkat(dirfd(dir), entry->d_name, 0);
+				continue;
+			}
+			if (!parseHexHash(entry->d_name, hash)) {
+				continue;
+			}
+			struct stat st;
+			if (fstatat(dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISREG(st.st_mode)) {
+				continue;
+			}
+			IndexEntry& indexEntry = found[hash];
+			indexEntry.size = st.st_size;
+			// The modification time is set on every access, atime might be disabled
+			indexEntry.accessTime = std::max(timespecNs(internal::modificationTime(st)), timespecNs(internal::accessTime(st)));
+		}
+		closedir(dir);
+	}
+}
+
+}  // namespace
+
+struct CacheStore::CacheStoreData {
+	std::string folder;
+	std::string indexPath;
+	CacheStoreLimits limits;
+	std::mutex mutex;
+	int rootFd;
+	int lockFd;
+	// The journal. Reopened when another process replaces it.
+	int indexFd;
+	ino_t indexInode;
+	off_t indexOffset;
+	std::size_t journalRecords;
+	IndexMap index;
+	std::uint64_t bytes;
+	unsigned tmpCounter;
+
+	CacheStoreData() : rootFd(-1), lockFd(-1), indexFd(-1), indexInode(0), indexOffset(0), journalRecords(0), bytes(0), tmpCounter(0) {}
+
+	~CacheStoreData() {
+		if (indexFd >= 0) {
+			close(indexFd);
+		}
+		if (lockFd >= 0) {
+			close(lockFd);
+		}
+		if (rootFd >= 0) {
+			close(rootFd);
+		}
+	}
+
+	void entryPath(std::uint64_t hash, char* shard, char* name) const {
+		hexHash(hash, name);
+		shard[0] = name[0];
+		shard[1] = name[1];
+		shard[2] = '\0';
+	}
+
+	void applyRecord(const IndexRecord& record) {
+		IndexMap::iterator itr = index.find(record.hash);
+		if (itr != index.end()) {
+			bytes -= itr->second.size;
+		}
+		if (record.op == RecordPut) {
+			IndexEntry& entry = index[record.hash];
+			entry.size = record.size;
+			entry.accessTime = record.accessTime;
+			bytes += record.size;
+		}
+		else if (itr != index.end()) {
+			index.erase(itr);
+		}
+		++journalRecords;
+	}
+
+	bool openIndex() {
+		if (indexFd >= 0) {
+			close(indexFd);
+		}
+		index.clear();
+		bytes = 0;
+		journalRecords = 0;
+		indexFd = open(indexPath.c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+		if (indexFd < 0) {
+			return false;
+		}
+		struct stat st;
+		char magic[sizeof(indexMagic)];
+		if (fstat(indexFd, &st) != 0 || pread(indexFd, magic, sizeof(magic), 0) != static_cast<ssize_t>(sizeof(magic))
+				|| std::memcmp(magic, indexMagic, sizeof(magic)) != 0) {
+			return false;
+		}
+		indexInode = st.st_ino;
+		indexOffset = sizeof(indexMagic);
+		return true;
+	}
+
+	/**
+	 * Reads what has been appended to the journal since the last call.
+	 * Must be called with both locks held. Rebuilds the index if it is missing or damaged.
+	 */
+	void syncIndex() {
+		struct stat st;
+		if (indexFd < 0 || stat(indexPath.c_str(), &st) != 0 || st.st_ino != indexInode) {
+			// Missing or compacted by another process
+			if (!openIndex()) {
+				rebuild();
+				return;
+			}
+		}
+		if (fstat(indexFd, &st) != 0) {
+			throwErrno("Failed to read the cache index");
+		}
+		if (st.st_size < indexOffset) {
+			// Truncated by someone else. Read it again from the start.
+			if (!openIndex() || fstat(indexFd, &st) != 0) {
+				rebuild();
+				return;
+			}
+		}
+		std::vector<IndexRecord> records;
+		std::size_t available = (st.st_size - indexOffset) / sizeof(IndexRecord);
+		if (available > 0) {
+			records.resize(available);
+			ssize_t got = pread(indexFd, records.data(), available * sizeof(IndexRecord), indexOffset);
+			if (got != static_cast<ssize_t>(available * sizeof(IndexRecord))) {
+				rebuild();
+				return;
+			}
+			for (std::size_t i = 0; i < records.size(); ++i) {
+				if (records[i].op != RecordPut && records[i].op != RecordRemove) {
+					rebuild();
+					return;
+				}
+				applyRecord(records[i]);
+			}
+			indexOffset += got;
+		}
+		if (st.st_size != indexOffset) {
+			// A writer died in the middle of a record. We hold the lock so nobody is writing now.
+			if (ftruncate(indexFd, indexOffset) != 0) {
+				rebuild();
+			}
+		}
+	}
+
+	void append(const IndexRecord& record) {
+		if (!writeAll(indexFd, reinterpret_cast<const char*>(&record), sizeof(record))) {
+			throwErrno("Failed to update the cache index");
+		}
+		indexOffset += sizeof(record);
+		applyRecord(record);
+	}
+
+	/**
+	 * Writes a new journal with one record per entry and swaps it in.
+	 */
+	void writeCompacted() {
+		std::string tmpPath = indexPath + ".tmp";
+		int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+		if (fd < 0) {
+			throwErrno("Failed to write the cache index");
+		}
+		std::vector<char> out;
+		out.reserve(sizeof(indexMagic) + index.size() * sizeof(IndexRecord));
+		out.insert(out.end(), indexMagic, indexMagic + sizeof(indexMagic));
+		for (IndexMap::const_iterator itr = index.begin(); itr != index.end(); ++itr) {
+			IndexRecord record;
+			record.op = RecordPut;
+			record.hash = itr->first;
+			record.size = itr->second.size;
+			record.accessTime = itr->second.accessTime;
+			const char* p = reinterpret_cast<const char*>(&record);
+			out.insert(out.end(), p, p + sizeof(record));
+		}
+		bool ok = writeAll(fd, out.data(), out.size());
+		close(fd);
+		if (!ok || rename(tmpPath.c_str(), indexPath.c_str()) != 0) {
+			unlink(tmpPath.c_str());
+			throwErrno("Failed to write the cache index");
+		}
+		IndexMap kept;
+		kept.swap(index);
+		if (!openIndex()) {
+			throwErrno("Failed to open the cache index");
+		}
+		index.swap(kept);
+		bytes = 0;
+		for (IndexMap::const_iterator itr = index.begin(); itr != index.end(); ++itr) {
+			bytes += itr->second.size;
+		}
+		journalRecords = index.size();
+		indexOffset = out.size();
+	}
+
+	void compactIfNeeded() {
+		if (journalRecords > 2 * index.size() + 1024) {
+			writeCompacted();
+		}
+	}
+
+	/**
+	 * Scans all shards with several threads and writes a new index.
+	 */
+	void rebuild() {
+		unsigned threads = std::thread::hardware_concurrency();
+		threads = std::max(1u, std::min(threads, 8u));
+		std::vector<IndexMap> found(threads);
+		std::vector<std::thread> workers;
+		std::size_t perThread = (shardCount + threads - 1) / threads;
+		for (unsigned t = 0; t < threads; ++t) {
+			std::size_t first = t * perThread;
+			std::size_t last = std::min(shardCount, first + perThread);
+			workers.push_back(std::thread(scanShards, rootFd, first, last, std::ref(found[t])));
+		}
+		for (std::size_t t = 0; t < workers.size(); ++t) {
+			workers[t].join();
+		}
+		index.clear();
+		for (std::size_t t = 0; t < found.size(); ++t) {
+			index.insert(found[t].begin(), found[t].end());
+		}
+		writeCompacted();
+	}
+
+	void removeEntry(std::uint64_t hash) {
+		char shard[3];
+		char name[17];
+		entryPath(hash, shard, name);
+		std::string path = std::string(shard) + "/" + name;
+		unlinkat(rootFd, path.c_str(), 0);
+		IndexRecord record = { RecordRemove, hash, 0, 0 };
+		append(record);
+	}
+
+	/**
+	 * Removes the least recently used entries until the store is below 90% of its budget
+	 */
+	void evictIfNeeded() {
+		if (bytes <= limits.maxBytes && index.size() <= limits.maxEntries) {
+			return;
+		}
+		std::vector<std::pair<std::int64_t, std::uint64_t> > byAge;
+		byAge.reserve(index.size());
+		for (IndexMap::const_iterator itr = index.begin(); itr != index.end(); ++itr) {
+			byAge.push_back(std::make_pair(itr->second.accessTime, itr->first));
+		}
+		std::sort(byAge.begin(), byAge.end());
+		const std::uint64_t targetBytes = limits.maxBytes - limits.maxBytes / 10;
+		const std::size_t targetEntries = limits.maxEntries - limits.maxEntries / 10;
+		for (std::size_t i = 0; i < byAge.size() && (bytes > targetBytes || index.size() > targetEntries); ++i) {
+			removeEntry(byAge[i].second);
+		}
+	}
+};
+
+CacheStore::CacheStore(const std::string& app, const CacheStoreLimits& limits) {
+	this->data = new CacheStore::CacheStoreData();
+	try {
+		data->folder = ensureCacheDir(app);
+		data->indexPath = data->folder + "/index";
+		data->limits = limits;
+		data->rootFd = internal::openReadableFolder(data->folder.c_str());
+		if (data->rootFd < 0) {
+			throwErrno("Failed to open \"" + data->folder + "\"");
+		}
+		data->lockFd = openat(data->rootFd, "lock", O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+		if (data->lockFd < 0) {
+			throwErrno("Failed to open the lock of \"" + data->folder + "\"");
+		}
+		FileLock lock(data->lockFd);
+		data->syncIndex();
+	}
+	catch (...) {
+		delete this->data;
+		throw;
+	}
+}
+
+CacheStore::~CacheStore() {
+	delete this->data;
+}
+
+bool CacheStore::get(const std::string& key, std::string& value) {
+	std::lock_guard<std::mutex> guard(data->mutex);
+	FileLock lock(data->lockFd);
+	data->syncIndex();
+	std::uint64_t hash = keyHash(key);
+	IndexMap::iterator itr = data->index.find(hash);
+	if (itr == data->index.end()) {
+		return false;
+	}
+	char shard[3];
+	char name[17];
+	data->entryPath(hash, shard, name);
+	std::string path = std::string(shard) + "/" + name;
+	int fd = openat(data->rootFd, path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		// Deleted behind our back
+		data->removeEntry(hash);
+		return false;
+	}
+	std::string contents;
+	struct stat st;
+	ssize_t got = -1;
+	if (fstat(fd, &st) == 0) {
+		contents.resize(st.st_size);
+		got = contents.empty() ? 0 : pread(fd, &contents[0], contents.size(), 0);
+	}
+	bool found = false;
+	std::uint32_t keyLength = 0;
+	if (got == static_cast<ssize_t>(contents.size()) && contents.size() >= sizeof(keyLength)) {
+		std::memcpy(&keyLength, contents.data(), sizeof(keyLength));
+		found = contents.size() - sizeof(keyLength) >= keyLength && contents.compare(sizeof(keyLength), keyLength, key) == 0;
+	}
+	if (found) {
+		value.assign(contents, sizeof(keyLength) + keyLength, std::string::npos);
+		std::int64_t now = nowNs();
+		if (now - itr->second.accessTime > touchIntervalNs) {
+			// Also visible to a rebuild through the modification time
+			futimens(fd, nullptr);
+			IndexRecord record = { RecordPut, hash, itr->second.size, now };
+			data->append(record);
+			data->compactIfNeeded();
+		}
+	}
+	close(fd);
+	return found;
+}
+
+void CacheStore::put(const std::string& key, const std::string& value) {
+	std::uint64_t hash = keyHash(key);
+	char shard[3];
+	char name[17];
+	data->entryPath(hash, shard, name);
+	std::uint32_t keyLength = static_cast<std::uint32_t>(key.size());
+	std::string contents;
+	contents.reserve(sizeof(keyLength) + key.size() + value.size());
+	contents.append(reinterpret_cast<const char*>(&keyLength), sizeof(keyLength));
+	contents += key;
+	contents += value;
+
+	std::lock_guard<std::mutex> guard(data->mutex);
+	FileLock lock(data->lockFd);
+	data->syncIndex();
+	if (mkdirat(data->rootFd, shard, 0700) != 0 && errno != EEXIST) {
+		throwErrno("Failed to create a cache shard in \"" + data->folder + "\"");
+	}
+	// Written next to the entry and renamed so readers never see a partial entry
+	char tmpName[64];
+	std::snprintf(tmpName, sizeof(tmpName), "%s/.tmp.%ld.%u", shard, static_cast<long>(getpid()), data->tmpCounter++);
+	int fd = openat(data->rootFd, tmpName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (fd < 0) {
+		throwErrno("Failed to write a cache entry in \"" + data->folder + "\"");
+	}
+	bool ok = writeAll(fd, contents.data(), contents.size());
+	close(fd);
+	std::string path = std::string(shard) + "/" + name;
+	if (!ok || renameat(data->rootFd, tmpName, data->rootFd, path.c_str()) != 0) {
+		unlinkat(data->rootFd, tmpName, 0);
+		throwErrno("Failed to write a cache entry in \"" + data->folder + "\"");
+	}
+	IndexRecord record = { RecordPut, hash, contents.size(), nowNs() };
+	data->append(record);
+	data->evictIfNeeded();
+	data->compactIfNeeded();
+}
+
+bool CacheStore::remove(const std::string& key) {
+	std::lock_guard<std::mutex> guard(data->mutex);
+	FileLock lock(data->lockFd);
+	data->syncIndex();
+	std::uint64_t hash = keyHash(key);
+	if (data->index.find(hash) == data->index.end()) {
+		return false;
+	}
+	data->removeEntry(hash);
+	data->compactIfNeeded();
+	return true;
+}
+
+void CacheStore::rebuildIndex() {
+	std::lock_guard<std::mutex> guard(data->mutex);
+	FileLock lock(data->lockFd);
+	data->rebuild();
+}
+
+std::size_t CacheStore::entryCount() {
+	std::lock_guard<std::mutex> guard(data->mutex);
+	FileLock lock(data->lockFd);
+	data->syncIndex();
+	return data->index.size();
+}
+
+std::uint64_t CacheStore::totalBytes() {
+	std::lock_guard<std::mutex> guard(data->mutex);
+	FileLock lock(data->lockFd);
+	data->syncIndex();
+	return data->bytes;
+}
+
+const std::string& CacheStore::folder() const {
+	return data->folder;
+}
+
+}  // namespace sago
+
+#endif
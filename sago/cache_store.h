@@ -0,0 +1,126 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SAGO_CACHE_STORE_H
+#define SAGO_CACHE_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace sago {
+
+#ifndef _WIN32
+
+/**
+ * The budget of a CacheStore. The least recently used entries are removed when either is exceeded.
+ */
+struct CacheStoreLimits {
+	std::uint64_t maxBytes;
+	std::size_t maxEntries;
+	CacheStoreLimits() : maxBytes(256 * 1024 * 1024), maxEntries(10000) {}
+};
+
+/**
+ * A key/value cache stored in getCacheDir()/<app>.
+ *
+ * Each entry is a file in one of 256 shard folders, named after a hash of the key.
+ * The file starts with the key so hash collisions are detected.
+ * An index with the size and last access time of every entry is kept in the file "index".
+ * It is an append only journal that is compacted when it grows, so an update only appends 32 bytes.
+ * Access times are only written if they are more than a minute old.
+ *
+ * Several processes can use the same store. Every operation holds an flock() on the file "lock"
+ * and first reads what other processes have appended to the index.
+ * If the index is missing or damaged, for example after a crash, it is rebuilt by scanning the
+ * shard folders with several threads.
+ * All methods may be called from several threads.
+ * @code{.cpp}
+ * sago::CacheStore cache("my_program");
+ * std::string thumbnail;
+ * if (!cache.get("photo.jpg@128", thumbnail)) {
+ *     thumbnail = makeThumbnail("photo.jpg", 128);
+ *     cache.put("photo.jpg@128", thumbnail);
+ * }
+ * @endcode
+ * @note Not available on Windows
+ */
+class CacheStore {
+public:
+	/**
+	 * Opens or creates the store. The folder is created if needed.
+	 * @param app The program name. The store is placed in getCacheDir()/app
+	 * @param limits The budget
+	 * @throws std::runtime_error if the folder or the index could not be opened
+	 */
+	explicit CacheStore(const std::string& app, const CacheStoreLimits& limits = CacheStoreLimits());
+	~CacheStore();
+	/**
+	 * @param key Any string
+	 * @param value Replaced with the stored value if found
+	 * @return true if the key was found
+	 */
+	bool get(const std::string& key, std::string& value);
+	/**
+	 * Stores a value. Old entries are evicted if the budget is exceeded.
+	 * @throws std::runtime_error if the entry could not be written
+	 */
+	void put(const std::string& key, const std::string& value);
+	/**
+	 * @return true if the key existed
+	 */
+	bool remove(const std::string& key);
+	/**
+	 * Throws away the index and scans the shard folders again.
+	 * This also picks up entries whose index update was lost in a crash.
+	 */
+	void rebuildIndex();
+	/**
+	 * @return The number of entries, including those added by other processes
+	 */
+	std::size_t entryCount();
+	/**
+	 * @return The size of all entry files in bytes
+	 */
+	std::uint64_t totalBytes();
+	/**
+	 * @return The folder of the store
+	 */
+	const std::string& folder() const;
+private:
+	CacheStore(const CacheStore&) = delete;
+	CacheStore& operator=(const CacheStore&) = delete;
+	struct CacheStoreData;
+	CacheStoreData* data;
+};
+
+#endif
+
+}  //namespace sago
+
+#endif  /* SAGO_CACHE_STORE_H */
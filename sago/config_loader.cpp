@@ -0,0 +1,289 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015-2016 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "config_loader.h"
+
+#ifndef _WIN32
+
+#include "internal_posix.h"
+#include "platform_folders.h"
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sago {
+
+namespace {
+
+/**
+ * What we compare to decide if a layer has to be mapped again
+ */
+struct LayerSignature {
+	dev_t device;
+	ino_t inode;
+	off_t size;
+	struct timespec mtime;
+};
+
+LayerSignature makeSignature(const struct stat& st) {
+	LayerSignature signature;
+	signature.device = st.st_dev;
+	signature.inode = st.st_ino;
+	signature.size = st.st_size;
+	signature.mtime = internal::modificationTime(st);
+	return signature;
+}
+
+/**
+ * True if someone other than root can write the file. It could then be truncated in place
+ * while it is mapped, and reading the mapping past the new end would raise SIGBUS.
+ */
+bool writableByUser(const struct stat& st) {
+	return st.st_uid != 0 || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0;
+}
+
+/**
+ * Reads the whole file from the start. It may have changed size since it was opened.
+ * @return false if a read failed. errno is then set.
+ */
+bool readFile(int fd, std::size_t sizeHint, std::string& contents) {
+	contents.resize(sizeHint);
+	std::size_t total = 0;
+	for (;;) {
+		if (total == contents.size()) {
+			contents.resize(contents.size() + 4096);
+		}
+		ssize_t count = pread(fd, &contents[total], contents.size() - total, total);
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		if (count == 0) {
+			break;
+		}
+		total += count;
+	}
+	contents.resize(total);
+	return true;
+}
+
+bool operator==(const LayerSignature& a, const LayerSignature& b) {
+	return a.device == b.device && a.inode == b.inode && a.size == b.size && a.mtime.tv_sec == b.mtime.tv_sec
+		&& a.mtime.tv_nsec == b.mtime.tv_nsec;
+}
+
+}  // namespace
+
+struct ConfigLayers::Mapping {
+	ConfigLayer layer;
+	LayerSignature signature;
+	// Null if the file was copied into contents instead of mapped
+	void* address;
+	std::string contents;
+
+	Mapping() : address(nullptr) {
+		layer.data = nullptr;
+		layer.size = 0;
+	}
+	~Mapping() {
+		if (address) {
+			munmap(address, layer.size);
+		}
+	}
+};
+
+const ConfigLayer& ConfigLayers::operator[](std::size_t index) const {
+	return mappings[index]->layer;
+}
+
+ConfigLayers::OverlayIterator ConfigLayers::begin() const {
+	return OverlayIterator(this, mappings.size());
+}
+
+ConfigLayers::OverlayIterator ConfigLayers::end() const {
+	return OverlayIterator(this, 0);
+}
+
+ConfigLayers::OverlayIterator::OverlayIterator(const ConfigLayers* layers, std::size_t layer) : layers(layers), layer(layer), offset(0), next(0) {
+	readLine();
+}
+
+ConfigLayers::OverlayIterator& ConfigLayers::OverlayIterator::operator++() {
+	offset = next;
+	readLine();
+	return *this;
+}
+
+void ConfigLayers::OverlayIterator::readLine() {
+	// Skip to the next layer with something left in it
+	while (layer > 0 && offset >= (*layers)[layer - 1].size) {
+		--layer;
+		offset = 0;
+	}
+	if (layer == 0) {
+		offset = 0;
+		next = 0;
+		return;
+	}
+	const ConfigLayer& current = (*layers)[layer - 1];
+	const char* start = current.data + offset;
+	std::size_t remaining = current.size - offset;
+	const char* newline = static_cast<const char*>(std::memchr(start, '\n', remaining));
+	std::size_t size = newline ? static_cast<std::size_t>(newline - start) : remaining;
+	next = offset + size + (newline ? 1 : 0);
+	if (size > 0 && start[size - 1] == '\r') {
+		--size;
+	}
+	line.data = start;
+	line.size = size;
+	line.layer = layer - 1;
+}
+
+struct ConfigLoader::ConfigLoaderData {
+	std::string relativePath;
+	std::mutex mutex;
+	std::vector<std::string> paths;
+	unsigned long long generation;
+	// One per entry in paths. Null if the file did not exist last time.
+	std::vector<std::shared_ptr<const ConfigLayers::Mapping>> mappings;
+
+	// Must be called with the mutex held
+	void updatePaths() {
+		if (!paths.empty() && generation == getFolderCacheGeneration()) {
+			return;
+		}
+		generation = getFolderCacheGeneration();
+		std::vector<std::string> folders;
+		folders.push_back(getConfigHome());
+		appendAdditionalConfigDirectories(folders, FolderListNormalizeTrailingSlash | FolderListRemoveDuplicates);
+		paths.clear();
+		for (std::size_t i = 0; i < folders.size(); ++i) {
+			std::string& folder = folders[i];
+			if (folder.empty() || folder[folder.size() - 1] != '/') {
+				folder += '/';
+			}
+			paths.push_back(folder + relativePath);
+		}
+		mappings.clear();
+		mappings.resize(paths.size());
+	}
+
+	static std::shared_ptr<const ConfigLayers::Mapping> mapLayer(const std::string& path, const std::shared_ptr<const ConfigLayers::Mapping>& cached) {
+		typedef ConfigLayers::Mapping Mapping;
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+			return std::shared_ptr<const Mapping>();
+		}
+		if (cached && cached->signature == makeSignature(st)) {
+			return cached;
+		}
+		int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			if (errno == ENOENT) {
+				// Removed since the stat()
+				return std::shared_ptr<const Mapping>();
+			}
+			throw std::runtime_error("Failed to open \"" + path + "\": " + std::strerror(errno));
+		}
+		// Use what was actually opened in case the file was replaced since the stat()
+		if (fstat(fd, &st) != 0) {
+			int error = errno;
+			close(fd);
+			throw std::runtime_error("Failed to read \"" + path + "\": " + std::strerror(error));
+		}
+		std::shared_ptr<Mapping> mapping = std::make_shared<Mapping>();
+		mapping->layer.path = path;
+		mapping->signature = makeSignature(st);
+		if (writableByUser(st)) {
+			if (!readFile(fd, st.st_size, mapping->contents)) {
+				int error = errno;
+				close(fd);
+				throw std::runtime_error("Failed to read \"" + path + "\": " + std::strerror(error));
+			}
+			mapping->layer.data = mapping->contents.data();
+			mapping->layer.size = mapping->contents.size();
+		}
+		else if (st.st_size > 0) {
+			void* address = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (address == MAP_FAILED) {
+				int error = errno;
+				close(fd);
+				throw std::runtime_error("Failed to map \"" + path + "\": " + std::strerror(error));
+			}
+			mapping->address = address;
+			mapping->layer.data = static_cast<const char*>(address);
+			mapping->layer.size = st.st_size;
+		}
+		// The mapping keeps the file alive
+		close(fd);
+		return mapping;
+	}
+};
+
+ConfigLoader::ConfigLoader(const std::string& app, const std::string& file) {
+	if (file.empty() || file[0] == '/' || (!app.empty() && app[0] == '/')) {
+		throw std::runtime_error("The config file \"" + app + "/" + file + "\" must be relative");
+	}
+	this->data = new ConfigLoader::ConfigLoaderData();
+	data->relativePath = app.empty() ? file : app + "/" + file;
+	data->generation = 0;
+}
+
+ConfigLoader::~ConfigLoader() {
+	delete this->data;
+}
+
+ConfigLayers ConfigLoader::load() {
+	std::lock_guard<std::mutex> lock(data->mutex);
+	data->updatePaths();
+	ConfigLayers layers;
+	for (std::size_t i = 0; i < data->paths.size(); ++i) {
+		data->mappings[i] = ConfigLoaderData::mapLayer(data->paths[i], data->mappings[i]);
+		if (data->mappings[i]) {
+			layers.mappings.push_back(data->mappings[i]);
+		}
+	}
+	return layers;
+}
+
+std::vector<std::string> ConfigLoader::paths() {
+	std::lock_guard<std::mutex> lock(data->mutex);
+	data->updatePaths();
+	return data->paths;
+}
+
+}  // namespace sago
+
+#endif
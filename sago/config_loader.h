@@ -0,0 +1,182 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SAGO_CONFIG_LOADER_H
+#define SAGO_CONFIG_LOADER_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sago {
+
+#ifndef _WIN32
+
+/**
+ * One existing copy of the config file. The contents are read only and are not null terminated.
+ */
+struct ConfigLayer {
+	/// Full path of the file
+	std::string path;
+	const char* data;
+	std::size_t size;
+};
+
+/**
+ * One line of a layer without the line break.
+ */
+struct ConfigLine {
+	const char* data;
+	std::size_t size;
+	/// Index into ConfigLayers, 0 is the most important layer
+	std::size_t layer;
+	std::string str() const {
+		return std::string(data, size);
+	}
+};
+
+/**
+ * The layers of a config file as they were when ConfigLoader::load() was called.
+ * The mappings stay valid as long as this object or a copy of it exists, even if the loader maps the files again.
+ */
+class ConfigLayers {
+public:
+	/**
+	 * Visits the lines of all layers with the least important layer first.
+	 * Applying every line in order leaves the values of the most important layer in place.
+	 */
+	class OverlayIterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef ConfigLine value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const ConfigLine* pointer;
+		typedef const ConfigLine& reference;
+
+		OverlayIterator() : layers(nullptr), layer(0), offset(0), next(0) {}
+		const ConfigLine& operator*() const {
+			return line;
+		}
+		const ConfigLine* operator->() const {
+			return &line;
+		}
+		OverlayIterator& operator++();
+		OverlayIterator operator++(int) {
+			OverlayIterator copy = *this;
+			++*this;
+			return copy;
+		}
+		bool operator==(const OverlayIterator& other) const {
+			return layer == other.layer && offset == other.offset;
+		}
+		bool operator!=(const OverlayIterator& other) const {
+			return !(*this == other);
+		}
+	private:
+		friend class ConfigLayers;
+		OverlayIterator(const ConfigLayers* layers, std::size_t layer);
+		void readLine();
+		const ConfigLayers* layers;
+		// Counts down from the least important layer. 0 is the end.
+		std::size_t layer;
+		// Start of the current line and of the one after it
+		std::size_t offset;
+		std::size_t next;
+		ConfigLine line;
+	};
+
+	ConfigLayers() {}
+	/**
+	 * @return Number of layers that exist
+	 */
+	std::size_t size() const {
+		return mappings.size();
+	}
+	bool empty() const {
+		return mappings.empty();
+	}
+	/**
+	 * @param index 0 is the most important layer, usually the one in getConfigHome()
+	 */
+	const ConfigLayer& operator[](std::size_t index) const;
+	OverlayIterator begin() const;
+	OverlayIterator end() const;
+private:
+	friend class ConfigLoader;
+	struct Mapping;
+	std::vector<std::shared_ptr<const Mapping>> mappings;
+};
+
+/**
+ * Loads "<app>/<file>" from getConfigHome() and the folders from appendAdditionalConfigDirectories().
+ * Files that only root can write, like the ones in /etc/xdg, are memory mapped. Files that another user can
+ * write are copied instead, as truncating a mapped file in place would crash the reader with SIGBUS.
+ * load() only reads a file again if its inode, size or modification time changed, so calling it often is cheap.
+ * The folders are looked up again if the process-wide cache generation changes, see sago::invalidateFolderCache().
+ * All methods may be called from several threads.
+ * @code{.cpp}
+ * sago::ConfigLoader loader("my_program", "settings.ini");
+ * sago::ConfigLayers layers = loader.load();
+ * for (const sago::ConfigLine& line : layers) {
+ * 	applySetting(line.data, line.size);
+ * }
+ * @endcode
+ * @note Not available on Windows
+ */
+class ConfigLoader {
+public:
+	/**
+	 * @param app Subfolder in the config folders. May be empty.
+	 * @param file Name of the file. May contain further subfolders.
+	 */
+	ConfigLoader(const std::string& app, const std::string& file);
+	~ConfigLoader();
+	/**
+	 * Checks every layer and maps or copies the ones that changed.
+	 * @return The current layers, most important first
+	 * @throws std::runtime_error if an existing file could not be read
+	 */
+	ConfigLayers load();
+	/**
+	 * @return The paths that are checked, most important first. They do not have to exist.
+	 */
+	std::vector<std::string> paths();
+private:
+	ConfigLoader(const ConfigLoader&) = delete;
+	ConfigLoader& operator=(const ConfigLoader&) = delete;
+	struct ConfigLoaderData;
+	ConfigLoaderData* data;
+};
+
+#endif
+
+}  //namespace sago
+
+#endif  /* SAGO_CONFIG_LOADER_H */
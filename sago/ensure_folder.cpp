@@ -0,0 +1,230 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015-2016 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ensure_folder.h"
+
+#ifndef _WIN32
+
+#include "internal_posix.h"
+#include "platform_folders.h"
+#include <cerrno>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sago {
+
+namespace {
+
+/**
+ * Folders that are known to exist. Cleared when the process-wide cache generation changes.
+ */
+struct EnsuredFolders {
+	std::mutex mutex;
+	std::unordered_set<std::string> folders;
+	unsigned long long generation;
+	EnsuredFolders() : generation(0) {}
+};
+
+EnsuredFolders& ensuredFolders() {
+	// Intentionally never destroyed
+	static EnsuredFolders* folders = new EnsuredFolders();
+	return *folders;
+}
+
+// Must be called with the mutex held
+bool isKnown(EnsuredFolders& known, const std::string& path) {
+	unsigned long long generation = getFolderCacheGeneration();
+	if (known.generation != generation) {
+		known.folders.clear();
+		known.generation = generation;
+	}
+	return known.folders.count(path) > 0;
+}
+
+/**
+ * Removes repeated and trailing slashes. "/a//b/" becomes "/a/b".
+ */
+std::string normalizeFolder(const std::string& path) {
+	std::string result;
+	result.reserve(path.size());
+	for (std::size_t i = 0; i < path.size(); ++i) {
+		if (path[i] == '/' && !result.empty() && result[result.size() - 1] == '/') {
+			continue;
+		}
+		result += path[i];
+	}
+	if (result.size() > 1 && result[result.size() - 1] == '/') {
+		result.erase(result.size() - 1);
+	}
+	return result;
+}
+
+class FileDescriptor {
+public:
+	explicit FileDescriptor(int fd) : fd(fd) {}
+	~FileDescriptor() {
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+	void reset(int newFd) {
+		if (fd >= 0) {
+			close(fd);
+		}
+		fd = newFd;
+	}
+	int get() const {
+		return fd;
+	}
+private:
+	FileDescriptor(const FileDescriptor&) = delete;
+	FileDescriptor& operator=(const FileDescriptor&) = delete;
+	int fd;
+};
+
+}  // namespace
+
+std::string ensureFolder(const std::string& path) {
+	if (path.empty() || path[0] != '/') {
+		throw std::runtime_error("Cannot create the relative folder \"" + path + "\". The path must be absolute.");
+	}
+	if (internal::hasDotComponent(path)) {
+		// The known folders are matched by name, so "/a/../b" must not be taken for a folder below "/a"
+		throw std::runtime_error("Cannot create the folder \"" + path + "\". The path must not contain \".\" or \"..\".");
+	}
+	const std::string folder = normalizeFolder(path);
+	EnsuredFolders& known = ensuredFolders();
+	// Offsets of the '/' that ends each parent. The deepest parent is last.
+	std::vector<std::size_t> parents;
+	for (std::size_t i = 1; i < folder.size(); ++i) {
+		if (folder[i] == '/') {
+			parents.push_back(i);
+		}
+	}
+	// The deepest parent that is known to exist
+	std::size_t existingEnd = 0;
+	{
+		std::lock_guard<std::mutex> lock(known.mutex);
+		if (isKnown(known, folder)) {
+			return folder;
+		}
+		for (std::size_t i = parents.size(); i > 0; --i) {
+			if (known.folders.count(folder.substr(0, parents[i - 1]))) {
+				existingEnd = parents[i - 1];
+				break;
+			}
+		}
+	}
+	FileDescriptor dir(-1);
+	std::size_t openedEnd = folder.size();
+	if (existingEnd > 0) {
+		// mkdirat() below tolerates folders that already exist, so starting from a known parent is always correct
+		dir.reset(internal::openFolder(folder.substr(0, existingEnd).c_str()));
+		if (dir.get() >= 0) {
+			openedEnd = existingEnd;
+		}
+	}
+	// Otherwise walk up until a folder can be opened. Usually the first or second try succeeds.
+	while (dir.get() < 0) {
+		std::string candidate = openedEnd == 0 ? std::string("/") : folder.substr(0, openedEnd);
+		dir.reset(internal::openFolder(candidate.c_str()));
+		if (dir.get() >= 0) {
+			break;
+		}
+		if (errno != ENOENT || openedEnd == 0) {
+			internal::throwErrno("Failed to open \"" + candidate + "\"");
+		}
+		openedEnd = folder.rfind('/', openedEnd - 1);
+	}
+	// Create the missing components one at a time relative to their parent
+	std::size_t start = openedEnd;
+	while (start < folder.size()) {
+		std::size_t nameStart = start + 1;
+		std::size_t nameEnd = folder.find('/', nameStart);
+		if (nameEnd == std::string::npos) {
+			nameEnd = folder.size();
+		}
+		const std::string name = folder.substr(nameStart, nameEnd - nameStart);
+		if (mkdirat(dir.get(), name.c_str(), 0700) != 0 && errno != EEXIST) {
+			internal::throwErrno("Failed to create \"" + folder.substr(0, nameEnd) + "\"");
+		}
+		int child = internal::openFolderAt(dir.get(), name.c_str());
+		if (child < 0) {
+			internal::throwErrno("Failed to open \"" + folder.substr(0, nameEnd) + "\"");
+		}
+		dir.reset(child);
+		start = nameEnd;
+	}
+	std::lock_guard<std::mutex> lock(known.mutex);
+	isKnown(known, folder);
+	known.folders.insert(folder);
+	for (std::size_t i = 0; i < parents.size(); ++i) {
+		known.folders.insert(folder.substr(0, parents[i]));
+	}
+	return folder;
+}
+
+static std::string ensureSubfolder(const std::string& base, const std::string& subfolder) {
+	if (subfolder.empty()) {
+		return ensureFolder(base);
+	}
+	if (subfolder[0] == '/' || internal::hasDotComponent(subfolder)) {
+		throw std::runtime_error("The subfolder \"" + subfolder + "\" must be relative and must not contain \".\" or \"..\"");
+	}
+	return ensureFolder(base + "/" + subfolder);
+}
+
+std::string ensureDataHome(const std::string& subfolder) {
+	return ensureSubfolder(getDataHome(), subfolder);
+}
+
+std::string ensureConfigHome(const std::string& subfolder) {
+	return ensureSubfolder(getConfigHome(), subfolder);
+}
+
+std::string ensureCacheDir(const std::string& subfolder) {
+	return ensureSubfolder(getCacheDir(), subfolder);
+}
+
+std::string ensureStateDir(const std::string& subfolder) {
+	return ensureSubfolder(getStateDir(), subfolder);
+}
+
+void forgetEnsuredFolders() {
+	EnsuredFolders& known = ensuredFolders();
+	std::lock_guard<std::mutex> lock(known.mutex);
+	known.folders.clear();
+}
+
+}  // namespace sago
+
+#endif
@@ -0,0 +1,88 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SAGO_ENSURE_FOLDER_H
+#define SAGO_ENSURE_FOLDER_H
+
+#include <string>
+
+namespace sago {
+
+#ifndef _WIN32
+
+/**
+ * Creates a folder and all missing parents, like "mkdir -p".
+ * Only the missing part is created. It starts from the deepest folder that already exists and
+ * creates the rest with mkdirat(), so the path is not walked from the root every time.
+ * New folders get mode 0700 as XDG requires for the base folders. Existing folders are not changed.
+ * Folders that have been created or found are remembered, so calling this again for the same
+ * folder, or one of its parents, does not make any system calls.
+ * @param path An absolute path without "." or ".." components
+ * @return path without trailing slashes
+ * @throws std::runtime_error if the path is relative, has a "." or ".." component or a folder could not be created
+ * @note Not available on Windows
+ */
+std::string ensureFolder(const std::string& path);
+
+/**
+ * getDataHome() with subfolder appended. The result is created by ensureFolder().
+ * @code{.cpp}
+ * std::string folder = sago::ensureDataHome("my_program");  // ~/.local/share/my_program now exists
+ * @endcode
+ * @param subfolder A relative path without "." or ".." components. May be empty.
+ * @return The folder that now exists
+ * @throws std::runtime_error if subfolder would leave the base folder or a folder could not be created
+ */
+std::string ensureDataHome(const std::string& subfolder = std::string());
+
+/**
+ * Like ensureDataHome() for getConfigHome()
+ */
+std::string ensureConfigHome(const std::string& subfolder = std::string());
+
+/**
+ * Like ensureDataHome() for getCacheDir()
+ */
+std::string ensureCacheDir(const std::string& subfolder = std::string());
+
+/**
+ * Like ensureDataHome() for getStateDir()
+ */
+std::string ensureStateDir(const std::string& subfolder = std::string());
+
+/**
+ * Forgets which folders are known to exist. Use this if folders might have been deleted.
+ * sago::invalidateFolderCache() does the same.
+ */
+void forgetEnsuredFolders();
+
+#endif
+
+}  //namespace sago
+
+#endif  /* SAGO_ENSURE_FOLDER_H */
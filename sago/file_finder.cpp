@@ -0,0 +1,287 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015-2016 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "file_finder.h"
+
+#ifndef _WIN32
+
+#include "internal_posix.h"
+#include "platform_folders.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace sago {
+
+namespace {
+
+struct SearchFolder {
+	std::string path;
+	int fd;
+};
+
+/**
+ * The opened folders of a search path. Immutable once built.
+ * Shared with the threads that are probing so the descriptors stay open until the last one is done.
+ */
+struct FolderList {
+	std::vector<SearchFolder> folders;
+	unsigned long long generation;
+	FolderList() : generation(0) {}
+	~FolderList() {
+		for (std::size_t i = 0; i < folders.size(); ++i) {
+			close(folders[i].fd);
+		}
+	}
+};
+
+std::shared_ptr<const FolderList> buildFolderList(SearchPath searchPath) {
+	std::shared_ptr<FolderList> list = std::make_shared<FolderList>();
+	list->generation = getFolderCacheGeneration();
+	std::vector<std::string> paths;
+	const int options = FolderListNormalizeTrailingSlash | FolderListRemoveDuplicates;
+	if (searchPath == SearchPath::Data) {
+		paths.push_back(getDataHome());
+		appendAdditionalDataDirectories(paths, options);
+	}
+	else {
+		paths.push_back(getConfigHome());
+		appendAdditionalConfigDirectories(paths, options);
+	}
+	for (std::size_t i = 0; i < paths.size(); ++i) {
+		SearchFolder folder;
+		// The descriptor is only used as a base for faccessat()
+		folder.fd = internal::openFolder(paths[i].c_str());
+		if (folder.fd < 0) {
+			// Folders that do not exist cannot contain anything
+			continue;
+		}
+		folder.path.swap(paths[i]);
+		if (folder.path.empty() || folder.path[folder.path.size() - 1] != '/') {
+			folder.path += '/';
+		}
+		list->folders.push_back(folder);
+	}
+	return list;
+}
+
+bool isValidRelativePath(const std::string& relativePath) {
+	return !relativePath.empty() && relativePath[0] != '/';
+}
+
+bool existsIn(const SearchFolder& folder, const std::string& relativePath) {
+	return faccessat(folder.fd, relativePath.c_str(), F_OK, 0) == 0;
+}
+
+}  // namespace
+
+struct FileFinder::FileFinderData {
+	SearchPath searchPath;
+	std::size_t negativeCacheSize;
+	std::mutex mutex;
+	std::shared_ptr<const FolderList> list;
+	// Names that were not found. The oldest is dropped when the cache is full.
+	std::unordered_set<std::string> misses;
+	std::deque<std::string> missOrder;
+
+	// Must be called with the mutex held
+	const std::shared_ptr<const FolderList>& currentList() {
+		if (!list || list->generation != getFolderCacheGeneration()) {
+			list = buildFolderList(searchPath);
+			misses.clear();
+			missOrder.clear();
+		}
+		return list;
+	}
+
+	// Must be called with the mutex held
+	void addMiss(const std::string& relativePath, const FolderList* searched) {
+		if (negativeCacheSize == 0 || searched != list.get()) {
+			// The folders were refreshed while searching. The result may already be stale.
+			return;
+		}
+		if (!misses.insert(relativePath).second) {
+			return;
+		}
+		missOrder.push_back(relativePath);
+		if (missOrder.size() > negativeCacheSize) {
+			misses.erase(missOrder.front());
+			missOrder.pop_front();
+		}
+	}
+
+	/**
+	 * Gets the folders to search. Returns nullptr if the name is a known miss.
+	 */
+	std::shared_ptr<const FolderList> prepare(const std::string& relativePath) {
+		std::lock_guard<std::mutex> lock(mutex);
+		std::shared_ptr<const FolderList> current = currentList();
+		if (misses.count(relativePath)) {
+			return std::shared_ptr<const FolderList>();
+		}
+		return current;
+	}
+
+	void rememberMiss(const std::string& relativePath, const FolderList* searched) {
+		std::lock_guard<std::mutex> lock(mutex);
+		addMiss(relativePath, searched);
+	}
+};
+
+FileFinder::FileFinder(SearchPath searchPath, std::size_t negativeCacheSize) {
+	this->data = new FileFinder::FileFinderData();
+	this->data->searchPath = searchPath;
+	this->data->negativeCacheSize = negativeCacheSize;
+}
+
+FileFinder::~FileFinder() {
+	delete this->data;
+}
+
+std::string FileFinder::find(const std::string& relativePath) {
+	if (!isValidRelativePath(relativePath)) {
+		return std::string();
+	}
+	std::shared_ptr<const FolderList> list = data->prepare(relativePath);
+	if (!list) {
+		return std::string();
+	}
+	for (std::size_t i = 0; i < list->folders.size(); ++i) {
+		if (existsIn(list->folders[i], relativePath)) {
+			return list->folders[i].path + relativePath;
+		}
+	}
+	data->rememberMiss(relativePath, list.get());
+	return std::string();
+}
+
+std::vector<std::string> FileFinder::findAll(const std::string& relativePath) {
+	std::vector<std::string> result;
+	if (!isValidRelativePath(relativePath)) {
+		return result;
+	}
+	std::shared_ptr<const FolderList> list = data->prepare(relativePath);
+	if (!list) {
+		return result;
+	}
+	for (std::size_t i = 0; i < list->folders.size(); ++i) {
+		if (existsIn(list->folders[i], relativePath)) {
+			result.push_back(list->folders[i].path + relativePath);
+		}
+	}
+	if (result.empty()) {
+		data->rememberMiss(relativePath, list.get());
+	}
+	return result;
+}
+
+void FileFinder::findMany(const std::vector<std::string>& relativePaths, std::vector<std::string>& results) {
+	results.assign(relativePaths.size(), std::string());
+	// Indexes into relativePaths that still need to be searched
+	std::vector<std::size_t> pending;
+	pending.reserve(relativePaths.size());
+	std::shared_ptr<const FolderList> list;
+	{
+		std::lock_guard<std::mutex> lock(data->mutex);
+		list = data->currentList();
+		for (std::size_t i = 0; i < relativePaths.size(); ++i) {
+			if (isValidRelativePath(relativePaths[i]) && !data->misses.count(relativePaths[i])) {
+				pending.push_back(i);
+			}
+		}
+	}
+	for (std::size_t f = 0; f < list->folders.size() && !pending.empty(); ++f) {
+		const SearchFolder& folder = list->folders[f];
+		std::size_t stillPending = 0;
+		for (std::size_t p = 0; p < pending.size(); ++p) {
+			std::size_t index = pending[p];
+			if (existsIn(folder, relativePaths[index])) {
+				results[index] = folder.path + relativePaths[index];
+			}
+			else {
+				pending[stillPending++] = index;
+			}
+		}
+		pending.resize(stillPending);
+	}
+	if (!pending.empty()) {
+		std::lock_guard<std::mutex> lock(data->mutex);
+		for (std::size_t p = 0; p < pending.size(); ++p) {
+			data->addMiss(relativePaths[pending[p]], list.get());
+		}
+	}
+}
+
+void FileFinder::refresh() {
+	std::shared_ptr<const FolderList> list = buildFolderList(data->searchPath);
+	std::lock_guard<std::mutex> lock(data->mutex);
+	data->list = list;
+	data->misses.clear();
+	data->missOrder.clear();
+}
+
+std::vector<std::string> FileFinder::folders() {
+	std::shared_ptr<const FolderList> list;
+	{
+		std::lock_guard<std::mutex> lock(data->mutex);
+		list = data->currentList();
+	}
+	std::vector<std::string> result;
+	for (std::size_t i = 0; i < list->folders.size(); ++i) {
+		const std::string& path = list->folders[i].path;
+		// Without the trailing slash that was added for joining
+		result.push_back(path.size() > 1 ? path.substr(0, path.size() - 1) : path);
+	}
+	return result;
+}
+
+static FileFinder& processFileFinder(SearchPath searchPath) {
+	// Intentionally never destroyed so they also work during static destruction
+	static FileFinder* dataFinder = new FileFinder(SearchPath::Data);
+	static FileFinder* configFinder = new FileFinder(SearchPath::Config);
+	return searchPath == SearchPath::Data ? *dataFinder : *configFinder;
+}
+
+std::string findDataFile(const std::string& relativePath) {
+	return processFileFinder(SearchPath::Data).find(relativePath);
+}
+
+std::string findConfigFile(const std::string& relativePath) {
+	return processFileFinder(SearchPath::Config).find(relativePath);
+}
+
+std::vector<std::string> findAll(SearchPath searchPath, const std::string& relativePath) {
+	return processFileFinder(searchPath).findAll(relativePath);
+}
+
+}  // namespace sago
+
+#endif
@@ -0,0 +1,122 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SAGO_FILE_FINDER_H
+#define SAGO_FILE_FINDER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace sago {
+
+#ifndef _WIN32
+
+/**
+ * The XDG search paths.
+ */
+enum class SearchPath {
+	/// getDataHome() followed by appendAdditionalDataDirectories()
+	Data,
+	/// getConfigHome() followed by appendAdditionalConfigDirectories()
+	Config
+};
+
+/**
+ * Finds files relative to the folders of a search path, in order of preference.
+ * The folders are opened once and probed with faccessat() relative to the open folder.
+ * Names that were not found in any folder are remembered in a bounded negative cache, so asking
+ * for a missing file again costs no system calls. The folders are opened again and the negative
+ * cache is cleared if the process-wide cache generation changes, see sago::invalidateFolderCache(),
+ * or if refresh() is called.
+ * All methods may be called from several threads.
+ * @code{.cpp}
+ * sago::FileFinder finder(sago::SearchPath::Data);
+ * std::string icon = finder.find("my_program/icon.png");
+ * @endcode
+ * @note Not available on Windows
+ */
+class FileFinder {
+public:
+	/**
+	 * @param searchPath The folders to search
+	 * @param negativeCacheSize How many missing names to remember. 0 disables the negative cache.
+	 */
+	explicit FileFinder(SearchPath searchPath, std::size_t negativeCacheSize = 256);
+	~FileFinder();
+	/**
+	 * @param relativePath Path relative to the folders in the search path, like "my_program/settings.ini"
+	 * @return The full path of the first match or an empty string if there is none
+	 */
+	std::string find(const std::string& relativePath);
+	/**
+	 * @param relativePath Path relative to the folders in the search path
+	 * @return The full paths of all matches, most important first
+	 */
+	std::vector<std::string> findAll(const std::string& relativePath);
+	/**
+	 * Finds many files at once. Each folder is visited once for all names.
+	 * @param relativePaths The names to look for
+	 * @param results Replaced with one entry per name. The first match or an empty string.
+	 */
+	void findMany(const std::vector<std::string>& relativePaths, std::vector<std::string>& results);
+	/**
+	 * Opens the folders again and forgets all misses. Use this after creating files that were looked for earlier.
+	 */
+	void refresh();
+	/**
+	 * @return The folders that are searched, most important first
+	 */
+	std::vector<std::string> folders();
+private:
+	FileFinder(const FileFinder&) = delete;
+	FileFinder& operator=(const FileFinder&) = delete;
+	struct FileFinderData;
+	FileFinderData* data;
+};
+
+/**
+ * Shorthand for FileFinder(SearchPath::Data).find() using a process-wide FileFinder.
+ */
+std::string findDataFile(const std::string& relativePath);
+
+/**
+ * Shorthand for FileFinder(SearchPath::Config).find() using a process-wide FileFinder.
+ */
+std::string findConfigFile(const std::string& relativePath);
+
+/**
+ * Shorthand for FileFinder::findAll() using a process-wide FileFinder.
+ */
+std::vector<std::string> findAll(SearchPath searchPath, const std::string& relativePath);
+
+#endif
+
+}  //namespace sago
+
+#endif  /* SAGO_FILE_FINDER_H */
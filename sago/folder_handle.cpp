@@ -0,0 +1,156 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015-2016 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "folder_handle.h"
+
+#ifndef _WIN32
+
+#include "ensure_folder.h"
+#include "internal_posix.h"
+#include <mutex>
+#include <unistd.h>
+
+namespace sago {
+
+struct FolderHandle::Descriptor {
+	int fd;
+	std::string path;
+	Descriptor(int fd, const std::string& path) : fd(fd), path(path) {}
+	~Descriptor() {
+		close(fd);
+	}
+private:
+	Descriptor(const Descriptor&) = delete;
+	Descriptor& operator=(const Descriptor&) = delete;
+};
+
+FolderHandle::FolderHandle() {
+}
+
+FolderHandle::FolderHandle(const std::string& path) {
+	int fd = internal::openFolder(path.c_str());
+	if (fd < 0) {
+		internal::throwErrno("Failed to open the folder \"" + path + "\"");
+	}
+	try {
+		descriptor = std::make_shared<const Descriptor>(fd, path);
+	}
+	catch (...) {
+		close(fd);
+		throw;
+	}
+}
+
+int FolderHandle::fd() const {
+	return descriptor ? descriptor->fd : -1;
+}
+
+const std::string& FolderHandle::path() const {
+	static const std::string empty;
+	return descriptor ? descriptor->path : empty;
+}
+
+bool FolderHandle::valid() const {
+	return descriptor.get() != nullptr;
+}
+
+namespace {
+
+const std::size_t baseDirCount = static_cast<std::size_t>(BaseDir::State) + 1;
+
+/**
+ * The cached handles. An invalid handle means not opened yet.
+ */
+struct FolderHandleCache {
+	std::mutex mutex;
+	unsigned long long generation;
+	FolderHandle baseDirs[baseDirCount];
+	FolderHandle folders[internal::folderCount];
+	FolderHandleCache() : generation(0) {}
+	// Must be called with the mutex held
+	void dropIfStale() {
+		unsigned long long current = getFolderCacheGeneration();
+		if (current != generation) {
+			clear();
+			generation = current;
+		}
+	}
+	// Must be called with the mutex held
+	void clear() {
+		for (std::size_t i = 0; i < baseDirCount; ++i) {
+			baseDirs[i] = FolderHandle();
+		}
+		for (std::size_t i = 0; i < internal::folderCount; ++i) {
+			folders[i] = FolderHandle();
+		}
+	}
+};
+
+FolderHandleCache& folderHandleCache() {
+	// Intentionally never destroyed
+	static FolderHandleCache* cache = new FolderHandleCache();
+	return *cache;
+}
+
+}  // namespace
+
+FolderHandle getFolderHandle(BaseDir dir, bool create) {
+	FolderHandleCache& cache = folderHandleCache();
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	cache.dropIfStale();
+	FolderHandle& slot = cache.baseDirs[static_cast<std::size_t>(dir)];
+	if (!slot.valid()) {
+		std::string path = getBaseDir(dir);
+		if (create) {
+			path = ensureFolder(path);
+		}
+		slot = FolderHandle(path);
+	}
+	return slot;
+}
+
+FolderHandle getFolderHandle(Folder folder) {
+	FolderHandleCache& cache = folderHandleCache();
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	cache.dropIfStale();
+	FolderHandle& slot = cache.folders[static_cast<std::size_t>(folder)];
+	if (!slot.valid()) {
+		slot = FolderHandle(getFolder(folder));
+	}
+	return slot;
+}
+
+void refreshFolderHandles() {
+	FolderHandleCache& cache = folderHandleCache();
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	cache.clear();
+}
+
+}  // namespace sago
+
+#endif
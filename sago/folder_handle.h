@@ -0,0 +1,102 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SAGO_FOLDER_HANDLE_H
+#define SAGO_FOLDER_HANDLE_H
+
+#include "platform_folders.h"
+#include <memory>
+#include <string>
+
+namespace sago {
+
+#ifndef _WIN32
+
+/**
+ * An open descriptor for a folder. Use it with openat(), fstatat() and similar functions
+ * so paths are resolved relative to the folder instead of from the root every time.
+ * Copies share the descriptor. It is closed when the last copy is destroyed.
+ * On Linux the folder is opened with O_PATH, so it can only be used as a base for the *at() functions.
+ * @code{.cpp}
+ * sago::FolderHandle config = sago::getFolderHandle(sago::BaseDir::Config);
+ * int fd = openat(config.fd(), "my_program/settings.ini", O_RDONLY | O_CLOEXEC);
+ * @endcode
+ * @note Not available on Windows
+ */
+class FolderHandle {
+public:
+	/**
+	 * A handle without a folder. valid() returns false.
+	 */
+	FolderHandle();
+	/**
+	 * Opens a folder.
+	 * @param path The folder to open
+	 * @throws std::runtime_error if it could not be opened
+	 */
+	explicit FolderHandle(const std::string& path);
+	/**
+	 * @return The descriptor or -1. Do not close it.
+	 */
+	int fd() const;
+	/**
+	 * @return The path the folder was opened from. The folder might have been moved since.
+	 */
+	const std::string& path() const;
+	bool valid() const;
+private:
+	struct Descriptor;
+	std::shared_ptr<const Descriptor> descriptor;
+};
+
+/**
+ * Returns a cached handle for one of the base folders.
+ * The handles are opened on first use and kept until the process-wide cache generation changes
+ * (see invalidateFolderCache()) or refreshFolderHandles() is called. The next call then opens the folder again.
+ * Handles that have already been returned stay valid and keep pointing to the folder they were opened from.
+ * @param dir The folder
+ * @param create If true the folder is created like ensureFolder() if it is missing
+ * @throws std::runtime_error if the folder does not exist or could not be opened
+ */
+FolderHandle getFolderHandle(BaseDir dir, bool create = false);
+
+/**
+ * Like getFolderHandle(BaseDir, bool) for one of the user folders. These are never created.
+ */
+FolderHandle getFolderHandle(Folder folder);
+
+/**
+ * Drops the cached handles. The next getFolderHandle() opens the folders again.
+ */
+void refreshFolderHandles();
+
+#endif
+
+}  //namespace sago
+
+#endif  /* SAGO_FOLDER_HANDLE_H */
@@ -0,0 +1,132 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015-2016 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "folder_warmup.h"
+#include "platform_folders.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace sago {
+
+struct FolderWarmup::State {
+	std::mutex mutex;
+	std::condition_variable changed;
+	WarmupStage stage;
+	bool done;
+	std::error_code error;
+	State() : stage(WarmupStage::Pending), done(false) {}
+
+	void advance(WarmupStage reached) {
+		std::lock_guard<std::mutex> lock(mutex);
+		stage = reached;
+	}
+
+	void finish(const std::error_code& ec) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			error = ec;
+			done = true;
+		}
+		changed.notify_all();
+	}
+
+	static void run(const std::shared_ptr<State>& state) {
+		std::error_code ec;
+#ifndef _WIN32
+		// The slow part on hosts with a remote name service. Getters that need the home folder wait on the passwd cache lock.
+		internal::getHome(ec);
+		if (ec) {
+			state->finish(ec);
+			return;
+		}
+#endif
+		state->advance(WarmupStage::Home);
+		// Reads user-dirs.dirs into the process-wide cache
+		internal::warmFolderCache(ec);
+		if (!ec) {
+			state->advance(WarmupStage::Folders);
+		}
+		state->finish(ec);
+	}
+};
+
+FolderWarmup::FolderWarmup() {
+}
+
+WarmupStage FolderWarmup::stage() const {
+	if (!state) {
+		return WarmupStage::Folders;
+	}
+	std::lock_guard<std::mutex> lock(state->mutex);
+	return state->stage;
+}
+
+bool FolderWarmup::ready() const {
+	if (!state) {
+		return true;
+	}
+	std::lock_guard<std::mutex> lock(state->mutex);
+	return state->done;
+}
+
+bool FolderWarmup::waitFor(std::chrono::milliseconds timeout) const {
+	if (!state) {
+		return true;
+	}
+	std::unique_lock<std::mutex> lock(state->mutex);
+	return state->changed.wait_for(lock, timeout, [this]() { return state->done; });
+}
+
+void FolderWarmup::wait(std::error_code& ec) const noexcept {
+	ec.clear();
+	if (!state) {
+		return;
+	}
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->changed.wait(lock, [this]() { return state->done; });
+	ec = state->error;
+}
+
+void FolderWarmup::wait() const {
+	std::error_code ec;
+	wait(ec);
+	if (ec) {
+		throw std::system_error(ec, "Folder warm-up failed");
+	}
+}
+
+FolderWarmup startFolderWarmup() {
+	FolderWarmup warmup;
+	warmup.state = std::make_shared<FolderWarmup::State>();
+	std::shared_ptr<FolderWarmup::State> state = warmup.state;
+	std::thread(FolderWarmup::State::run, state).detach();
+	return warmup;
+}
+
+}  // namespace sago
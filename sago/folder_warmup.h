@@ -0,0 +1,110 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SAGO_FOLDER_WARMUP_H
+#define SAGO_FOLDER_WARMUP_H
+
+#include <chrono>
+#include <memory>
+#include <system_error>
+
+namespace sago {
+
+/**
+ * How far a warm-up has come. Each stage includes the ones before it.
+ */
+enum class WarmupStage {
+	/// Nothing is cached yet
+	Pending,
+	/// The home folder is cached. The base folders no longer need a passwd lookup.
+	Home,
+	/// The user folders are in the process-wide cache. The warm-up is done.
+	Folders
+};
+
+/**
+ * A handle to a warm-up started by startFolderWarmup(). Copies refer to the same warm-up.
+ * The warm-up fills the same process-wide caches the getters use. A getter called before it is done only waits
+ * for the part it needs: getDataHome() waits for the home folder unless XDG_DATA_HOME is set, and the user folders
+ * wait for user-dirs.dirs to be read. Nothing is looked up twice.
+ * The background thread is detached. The handle does not have to be kept.
+ */
+class FolderWarmup {
+public:
+	/**
+	 * A handle without a warm-up. ready() returns true.
+	 */
+	FolderWarmup();
+	/**
+	 * @return How far the warm-up has come. A failed warm-up stays at the stage it reached.
+	 */
+	WarmupStage stage() const;
+	/**
+	 * @return true if the warm-up has finished or failed
+	 */
+	bool ready() const;
+	/**
+	 * Waits until the warm-up has finished or failed.
+	 * @param timeout The longest time to wait
+	 * @return ready()
+	 */
+	bool waitFor(std::chrono::milliseconds timeout) const;
+	/**
+	 * Waits until the warm-up has finished or failed.
+	 * @param ec Set if the folders could not be resolved, cleared otherwise
+	 */
+	void wait(std::error_code& ec) const noexcept;
+	/**
+	 * Waits until the warm-up has finished.
+	 * @throws std::system_error if the folders could not be resolved
+	 */
+	void wait() const;
+private:
+	friend FolderWarmup startFolderWarmup();
+	struct State;
+	std::shared_ptr<State> state;
+};
+
+/**
+ * Starts resolving the home folder and the user folders on a background thread.
+ * Call it early during startup when the first passwd lookup might be slow, like on hosts that use sssd or LDAP.
+ * @code{.cpp}
+ * int main() {
+ *     sago::FolderWarmup warmup = sago::startFolderWarmup();
+ *     parseCommandLine();
+ *     std::string config = sago::getConfigHome();  // Only waits if the home folder is not known yet
+ * }
+ * @endcode
+ * @return A handle to wait for the warm-up
+ * @throws std::system_error if the thread could not be started
+ */
+FolderWarmup startFolderWarmup();
+
+}  //namespace sago
+
+#endif  /* SAGO_FOLDER_WARMUP_H */
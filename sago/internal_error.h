@@ -0,0 +1,67 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef SAGO_INTERNAL_ERROR_H
+#define SAGO_INTERNAL_ERROR_H
+
+#include <new>
+#include <system_error>
+
+/*
+ * Error handling shared by the noexcept overloads of the library. Not installed and not part of the API.
+ */
+
+namespace sago {
+namespace internal {
+
+/**
+ * Runs body inside a noexcept function.
+ * The failure paths of the library report through ec and do not throw. What is left to catch here are
+ * failed allocations and exceptions from a custom EnvironmentProvider or PasswdProvider.
+ * @return What body returned or a default constructed value if it threw
+ */
+template <class Body>
+auto noThrow(std::error_code& ec, Body body) noexcept -> decltype(body()) {
+	try {
+		return body();
+	}
+	catch (const std::bad_alloc&) {
+		ec = std::make_error_code(std::errc::not_enough_memory);
+	}
+	catch (const std::system_error& e) {
+		ec = e.code();
+	}
+	catch (...) {
+		ec = std::make_error_code(std::errc::io_error);
+	}
+	return decltype(body())();
+}
+
+}  // namespace internal
+}  // namespace sago
+
+#endif  /* SAGO_INTERNAL_ERROR_H */
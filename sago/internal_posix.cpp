@@ -0,0 +1,124 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "internal_posix.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace sago {
+namespace internal {
+
+#ifdef O_PATH
+static const int PlatformFoldersFolderFlags = O_PATH | O_DIRECTORY | O_CLOEXEC;
+#else
+static const int PlatformFoldersFolderFlags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+#endif
+
+int openFolder(const char* path) {
+	return open(path, PlatformFoldersFolderFlags);
+}
+
+int openFolderAt(int dirfd, const char* name) {
+	return openat(dirfd, name, PlatformFoldersFolderFlags);
+}
+
+int openReadableFolder(const char* path) {
+	return open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+void throwErrno(const std::string& what) {
+	throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+bool isInsideFolder(const std::string& folder, const std::string& path) {
+	if (folder.find_first_not_of('/') == std::string::npos) {
+		// Everything is inside "/", so a home folder of "/" vouches for nothing
+		return false;
+	}
+	if (path.compare(0, folder.size(), folder) != 0) {
+		return false;
+	}
+	if (path.size() > folder.size() && folder[folder.size() - 1] != '/' && path[folder.size()] != '/') {
+		// "/home/alice2" is not inside "/home/alice"
+		return false;
+	}
+	std::size_t start = 0;
+	while (start < path.size()) {
+		std::size_t end = path.find('/', start);
+		if (end == std::string::npos) {
+			end = path.size();
+		}
+		if (end - start == 2 && path.compare(start, 2, "..") == 0) {
+			return false;
+		}
+		start = end + 1;
+	}
+	return true;
+}
+
+bool hasDotComponent(const std::string& path) {
+	std::size_t start = 0;
+	while (start < path.size()) {
+		std::size_t end = path.find('/', start);
+		if (end == std::string::npos) {
+			end = path.size();
+		}
+		std::size_t length = end - start;
+		if ((length == 1 && path[start] == '.') || (length == 2 && path.compare(start, 2, "..") == 0)) {
+			return true;
+		}
+		start = end + 1;
+	}
+	return false;
+}
+
+bool writeAll(int fd, const char* data, std::size_t size) {
+	while (size > 0) {
+		ssize_t written = ::write(fd, data, size);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+	return true;
+}
+
+}  // namespace internal
+}  // namespace sago
+
+#endif
@@ -0,0 +1,111 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef SAGO_INTERNAL_POSIX_H
+#define SAGO_INTERNAL_POSIX_H
+
+#ifndef _WIN32
+
+#include <cstddef>
+#include <string>
+#include <sys/stat.h>
+
+/*
+ * File helpers shared by the POSIX parts of the library. Not installed and not part of the API.
+ */
+
+namespace sago {
+namespace internal {
+
+/**
+ * Opens a folder to use as a base for openat(), mkdirat() and the other *at() functions.
+ * On Linux it is opened with O_PATH, which does not need read permission. The descriptor cannot be read or synced.
+ * @return The descriptor or -1 with errno set
+ */
+int openFolder(const char* path);
+
+/**
+ * Same as openFolder() but relative to the folder dirfd.
+ */
+int openFolderAt(int dirfd, const char* name);
+
+/**
+ * Opens a folder for reading. Needed for fsync() and fdopendir().
+ * @return The descriptor or -1 with errno set
+ */
+int openReadableFolder(const char* path);
+
+/**
+ * Throws std::runtime_error with what followed by the description of errno.
+ */
+[[noreturn]] void throwErrno(const std::string& what);
+
+/**
+ * True if path is folder or below it and has no ".." component that could lead back out.
+ * Always false for an empty folder or "/", as those would let any path in.
+ */
+bool isInsideFolder(const std::string& folder, const std::string& path);
+
+/**
+ * True if a component of path is "." or "..". Such a path can name a folder outside of where it appears to be.
+ */
+bool hasDotComponent(const std::string& path);
+
+/**
+ * Writes all of data. Retries short writes and EINTR.
+ * @return false if the write failed. errno is then set.
+ */
+bool writeAll(int fd, const char* data, std::size_t size);
+
+/**
+ * The modification time of st. macOS names the field st_mtimespec instead of st_mtim.
+ */
+inline struct timespec modificationTime(const struct stat& st) {
+#ifdef __APPLE__
+	return st.st_mtimespec;
+#else
+	return st.st_mtim;
+#endif
+}
+
+/**
+ * The access time of st
+ */
+inline struct timespec accessTime(const struct stat& st) {
+#ifdef __APPLE__
+	return st.st_atimespec;
+#else
+	return st.st_atim;
+#endif
+}
+
+}  // namespace internal
+}  // namespace sago
+
+#endif
+
+#endif  /* SAGO_INTERNAL_POSIX_H */
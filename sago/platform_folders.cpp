@@ -27,16 +27,632 @@ SOFTWARE.
 */
 
 #include "platform_folders.h"
+#include "internal_error.h"
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <cstdarg>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+
+namespace {
+
+using sago::internal::noThrow;
+
+/**
+ * Builds a path in a caller provided buffer without allocating.
+ * The full length is counted even if it does not fit. In that case the buffer is left with an empty string.
+ */
+class PathBuffer {
+public:
+	PathBuffer(char* buffer, std::size_t bufferSize) : buffer(buffer), bufferSize(bufferSize), length(0) {
+		if (bufferSize > 0) {
+			buffer[0] = '\0';
+		}
+	}
+	void append(const char* s) {
+		append(s, std::strlen(s));
+	}
+	void append(const char* s, std::size_t n) {
+		if (length + n < bufferSize) {
+			std::memcpy(buffer + length, s, n);
+			buffer[length + n] = '\0';
+		}
+		length += n;
+	}
+	std::size_t finish(std::error_code& ec) {
+		if (length >= bufferSize) {
+			if (bufferSize > 0) {
+				buffer[0] = '\0';
+			}
+			ec = std::make_error_code(std::errc::result_out_of_range);
+		}
+		return length;
+	}
+private:
+	char* buffer;
+	std::size_t bufferSize;
+	std::size_t length;
+};
+
+/**
+ * Turns an error code back into the exception the throwing API has always used.
+ */
+[[noreturn]] void throwError(const std::error_code& ec, const char* what) {
+	if (ec == std::errc::not_enough_memory) {
+		throw std::bad_alloc();
+	}
+	// std::system_error is a std::runtime_error, so existing handlers still catch it
+	throw std::system_error(ec, what);
+}
+
+}  // namespace
+
+#ifdef PLATFORMFOLDERS_ENABLE_STATS
+#include <chrono>
+
+namespace {
+
+struct AtomicHistogram {
+	std::atomic<unsigned long long> buckets[sago::LatencyHistogram::bucketCount];
+	std::atomic<unsigned long long> count;
+	std::atomic<unsigned long long> totalNanoseconds;
+	void record(unsigned long long nanoseconds) {
+		std::size_t bucket = 0;
+		for (unsigned long long limit = 1000; nanoseconds >= limit && bucket + 1 < sago::LatencyHistogram::bucketCount; limit *= 2) {
+			++bucket;
+		}
+		buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+		count.fetch_add(1, std::memory_order_relaxed);
+		totalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+	}
+};
+
+// Zero initialized as it has static storage duration
+struct StatsCounters {
+	std::atomic<unsigned long long> lookups;
+	std::atomic<unsigned long long> folderCacheHits;
+	std::atomic<unsigned long long> folderCacheMisses;
+	std::atomic<unsigned long long> userDirsReads;
+	std::atomic<unsigned long long> passwdLookups;
+	std::atomic<unsigned long long> passwdCacheHits;
+	std::atomic<unsigned long long> warnings;
+	std::atomic<unsigned long long> relativePathErrors;
+	AtomicHistogram resolve;
+	AtomicHistogram getHome;
+} statsCounters;
+
+class StatsTimer {
+public:
+	explicit StatsTimer(AtomicHistogram& histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+	~StatsTimer() {
+		histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+private:
+	StatsTimer(const StatsTimer&) = delete;
+	StatsTimer& operator=(const StatsTimer&) = delete;
+	AtomicHistogram& histogram;
+	std::chrono::steady_clock::time_point start;
+};
+
+}  // namespace
+
+#define PLATFORMFOLDERS_STAT_ADD(counter) statsCounters.counter.fetch_add(1, std::memory_order_relaxed)
+#define PLATFORMFOLDERS_STAT_TIMER(histogram) StatsTimer statsTimer(statsCounters.histogram)
+#else
+#define PLATFORMFOLDERS_STAT_ADD(counter) ((void)0)
+#define PLATFORMFOLDERS_STAT_TIMER(histogram) ((void)0)
+#endif
 
 #ifndef _WIN32
+#include <unistd.h>
+#ifdef __APPLE__
+#include <crt_externs.h>
+#else
+extern char** environ;
+#endif
+#endif
+
+namespace sago {
+
+namespace {
+const char* const environmentNames[Environment::VariableCount] = {
+	"HOME",
+	"XDG_DATA_HOME",
+	"XDG_CONFIG_HOME",
+	"XDG_CACHE_HOME",
+	"XDG_STATE_HOME",
+	"XDG_DATA_DIRS",
+	"XDG_CONFIG_DIRS",
+};
+
+/**
+ * The environment published as immutable copies. Same scheme as the passwd cache:
+ * readers load the current copy and keep it alive for as long as they use it.
+ */
+struct EnvironmentCache {
+	std::mutex mutex;
+	// Only accessed through std::atomic_load() and std::atomic_store()
+	std::shared_ptr<const Environment> current;
+	// True if current was captured from the process. Its uid is then checked against getuid().
+	std::atomic<bool> fromProcess;
+	EnvironmentProvider provider;
+	EnvironmentCache() : fromProcess(false) {}
+};
+
+EnvironmentCache& environmentCache() {
+	// Intentionally never destroyed
+	static EnvironmentCache* cache = new EnvironmentCache();
+	return *cache;
+}
+
+void invalidateEnvironment() {
+	EnvironmentCache& cache = environmentCache();
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	std::atomic_store(&cache.current, std::shared_ptr<const Environment>());
+}
 
+/**
+ * True if the process has changed its uid with setuid() since env was captured.
+ * A fake environment from a provider is never stale.
+ */
+bool staleUid(const EnvironmentCache& cache, const Environment& env) {
+#ifdef _WIN32
+	(void)cache;
+	(void)env;
+	return false;
+#else
+	return cache.fromProcess.load(std::memory_order_relaxed) && env.getUid() != getuid();
+#endif
+}
+
+}  // namespace
+
+Environment::Environment() : uid(0) {
+	for (std::size_t i = 0; i < VariableCount; ++i) {
+		offsets[i] = unsetOffset;
+	}
+}
+
+Environment Environment::fromProcess() {
+	Environment env;
+#ifdef _WIN32
+	for (std::size_t i = 0; i < VariableCount; ++i) {
+		const char* value = std::getenv(environmentNames[i]);
+		if (value) {
+			env.set(static_cast<Variable>(i), value);
+		}
+	}
+#else
+	env.uid = getuid();
+#ifdef __APPLE__
+	char** entries = *_NSGetEnviron();
+#else
+	char** entries = environ;
+#endif
+	for (char** itr = entries; itr && *itr; ++itr) {
+		const char* entry = *itr;
+		if (entry[0] != 'H' && entry[0] != 'X') {
+			continue;
+		}
+		const char* equals = std::strchr(entry, '=');
+		if (!equals) {
+			continue;
+		}
+		std::size_t nameLength = equals - entry;
+		for (std::size_t i = 0; i < VariableCount; ++i) {
+			// Like getenv() the first match wins
+			if (env.offsets[i] == unsetOffset && std::strncmp(entry, environmentNames[i], nameLength) == 0 && environmentNames[i][nameLength] == '\0') {
+				env.set(static_cast<Variable>(i), equals + 1);
+				break;
+			}
+		}
+	}
+#endif
+	return env;
+}
+
+const char* Environment::name(Variable variable) {
+	return environmentNames[variable];
+}
+
+const char* Environment::get(Variable variable) const {
+	if (offsets[variable] == unsetOffset) {
+		return nullptr;
+	}
+	return buffer.c_str() + offsets[variable];
+}
+
+void Environment::set(Variable variable, const std::string& value) {
+	// The old value is left in the buffer. It is small and rarely replaced.
+	offsets[variable] = buffer.size();
+	buffer.append(value).push_back('\0');
+}
+
+void Environment::unset(Variable variable) {
+	offsets[variable] = unsetOffset;
+}
+
+void setEnvironmentProvider(EnvironmentProvider provider) {
+	{
+		EnvironmentCache& cache = environmentCache();
+		std::lock_guard<std::mutex> lock(cache.mutex);
+		cache.provider = provider;
+	}
+	invalidateFolderCache();
+}
+
+std::shared_ptr<const Environment> getEnvironment() {
+	EnvironmentCache& cache = environmentCache();
+	std::shared_ptr<const Environment> env = std::atomic_load(&cache.current);
+	if (env && !staleUid(cache, *env)) {
+		return env;
+	}
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	env = std::atomic_load(&cache.current);
+	if (env && !staleUid(cache, *env)) {
+		return env;
+	}
+	cache.fromProcess.store(!cache.provider, std::memory_order_relaxed);
+	env = std::make_shared<const Environment>(cache.provider ? cache.provider() : Environment::fromProcess());
+	std::atomic_store(&cache.current, env);
+	return env;
+}
+
+namespace {
+
+/**
+ * The current sink is published like the environment. A thread that is calling
+ * a replaced sink keeps it alive until the call returns.
+ */
+struct DiagnosticState {
+	std::mutex mutex;
+	// Only accessed through std::atomic_load() and std::atomic_store()
+	std::shared_ptr<const DiagnosticSink> current;
+	std::atomic<unsigned long long> count;
+	DiagnosticState() : count(0) {}
+};
+
+DiagnosticState& diagnosticState() {
+	// Intentionally never destroyed
+	static DiagnosticState* state = new DiagnosticState();
+	return *state;
+}
+
+const std::size_t seenMessageCount = 64;
+
+/**
+ * Hashes of the messages the default sink has already written.
+ * Open addressing without a lock. A slot is claimed with a compare and swap.
+ */
+std::atomic<std::uint64_t> seenMessages[seenMessageCount];
+std::atomic<bool> seenMessagesFull(false);
+
+// FNV-1a. 0 marks an empty slot so it is never returned.
+std::uint64_t messageHash(const char* message) {
+	std::uint64_t hash = 14695981039346656037ULL;
+	for (const char* c = message; *c; ++c) {
+		hash ^= static_cast<unsigned char>(*c);
+		hash *= 1099511628211ULL;
+	}
+	return hash ? hash : 1;
+}
+
+// @return true the first time a message is seen
+bool markMessageSeen(const char* message) {
+	std::uint64_t hash = messageHash(message);
+	std::size_t start = hash % seenMessageCount;
+	for (std::size_t i = 0; i < seenMessageCount; ++i) {
+		std::atomic<std::uint64_t>& slot = seenMessages[(start + i) % seenMessageCount];
+		std::uint64_t expected = slot.load(std::memory_order_relaxed);
+		if (expected == hash) {
+			return false;
+		}
+		if (expected == 0) {
+			if (slot.compare_exchange_strong(expected, hash, std::memory_order_relaxed)) {
+				return true;
+			}
+			if (expected == hash) {
+				return false;
+			}
+		}
+	}
+	if (!seenMessagesFull.exchange(true)) {
+		std::cerr << "WARNING: Too many distinct problems with the folder configuration. Further warnings are not shown.\n";
+	}
+	return false;
+}
+
+void defaultDiagnosticSink(Diagnostic, const char* message) {
+	if (markMessageSeen(message)) {
+		std::cerr << message << "\n";
+	}
+}
+
+std::shared_ptr<const DiagnosticSink> currentDiagnosticSink() {
+	DiagnosticState& state = diagnosticState();
+	std::shared_ptr<const DiagnosticSink> sink = std::atomic_load(&state.current);
+	if (sink) {
+		return sink;
+	}
+	std::lock_guard<std::mutex> lock(state.mutex);
+	sink = std::atomic_load(&state.current);
+	if (!sink) {
+		sink = std::make_shared<const DiagnosticSink>(defaultDiagnosticSink);
+		std::atomic_store(&state.current, sink);
+	}
+	return sink;
+}
+
+}  // namespace
+
+void setDiagnosticSink(DiagnosticSink sink) {
+	DiagnosticState& state = diagnosticState();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	std::atomic_store(&state.current, std::make_shared<const DiagnosticSink>(sink));
+}
+
+void resetDiagnosticSink() {
+	setDiagnosticSink(defaultDiagnosticSink);
+}
+
+unsigned long long getDiagnosticCount() {
+	return diagnosticState().count.load(std::memory_order_relaxed);
+}
+
+#ifdef PLATFORMFOLDERS_ENABLE_STATS
+static void copyHistogram(const AtomicHistogram& from, LatencyHistogram& to) {
+	for (std::size_t i = 0; i < LatencyHistogram::bucketCount; ++i) {
+		to.buckets[i] = from.buckets[i].load(std::memory_order_relaxed);
+	}
+	to.count = from.count.load(std::memory_order_relaxed);
+	to.totalNanoseconds = from.totalNanoseconds.load(std::memory_order_relaxed);
+}
+
+static void resetHistogram(AtomicHistogram& histogram) {
+	for (std::size_t i = 0; i < LatencyHistogram::bucketCount; ++i) {
+		histogram.buckets[i].store(0, std::memory_order_relaxed);
+	}
+	histogram.count.store(0, std::memory_order_relaxed);
+	histogram.totalNanoseconds.store(0, std::memory_order_relaxed);
+}
+
+bool statsEnabled() {
+	return true;
+}
+
+void getStats(Stats& stats) {
+	stats.lookups = statsCounters.lookups.load(std::memory_order_relaxed);
+	stats.folderCacheHits = statsCounters.folderCacheHits.load(std::memory_order_relaxed);
+	stats.folderCacheMisses = statsCounters.folderCacheMisses.load(std::memory_order_relaxed);
+	stats.userDirsReads = statsCounters.userDirsReads.load(std::memory_order_relaxed);
+	stats.passwdLookups = statsCounters.passwdLookups.load(std::memory_order_relaxed);
+	stats.passwdCacheHits = statsCounters.passwdCacheHits.load(std::memory_order_relaxed);
+	stats.warnings = statsCounters.warnings.load(std::memory_order_relaxed);
+	stats.relativePathErrors = statsCounters.relativePathErrors.load(std::memory_order_relaxed);
+	copyHistogram(statsCounters.resolve, stats.resolve);
+	copyHistogram(statsCounters.getHome, stats.getHome);
+}
+
+void resetStats() {
+	statsCounters.lookups.store(0, std::memory_order_relaxed);
+	statsCounters.folderCacheHits.store(0, std::memory_order_relaxed);
+	statsCounters.folderCacheMisses.store(0, std::memory_order_relaxed);
+	statsCounters.userDirsReads.store(0, std::memory_order_relaxed);
+	statsCounters.passwdLookups.store(0, std::memory_order_relaxed);
+	statsCounters.passwdCacheHits.store(0, std::memory_order_relaxed);
+	statsCounters.warnings.store(0, std::memory_order_relaxed);
+	statsCounters.relativePathErrors.store(0, std::memory_order_relaxed);
+	resetHistogram(statsCounters.resolve);
+	resetHistogram(statsCounters.getHome);
+}
+#else
+bool statsEnabled() {
+	return false;
+}
+
+void getStats(Stats& stats) {
+	stats = Stats();
+}
+
+void resetStats() {
+}
+#endif
+
+namespace internal {
+
+/**
+ * Reports a diagnostic. printf style. Long messages are truncated.
+ * Nothing is formatted if diagnostics are silenced.
+ */
+void reportDiagnostic(Diagnostic kind, const char* format, ...) {
+	diagnosticState().count.fetch_add(1, std::memory_order_relaxed);
+	PLATFORMFOLDERS_STAT_ADD(warnings);
+	// Held until the call returns, so a sink replaced meanwhile stays alive
+	std::shared_ptr<const DiagnosticSink> sink = currentDiagnosticSink();
+	if (!*sink) {
+		return;
+	}
+	char message[512];
+	va_list args;
+	va_start(args, format);
+	std::vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+	(*sink)(kind, message);
+}
+
+}  // namespace internal
+
+}  // namespace sago
+
+#ifndef _WIN32
+
+#include <cerrno>
 #include <pwd.h>
 #include <unistd.h>
 
+/**
+ * The home directory from the passwd database for a given uid.
+ * Entries are immutable. A new entry is published when the uid or effective uid changes.
+ */
+struct PasswdHome {
+	uid_t uid;
+	uid_t euid;
+	std::string home;
+};
+
+struct PasswdHomeCache {
+	std::mutex mutex;
+	// Only accessed through std::atomic_load() and std::atomic_store()
+	std::shared_ptr<const PasswdHome> current;
+	sago::PasswdProvider provider;
+	sago::UserNameProvider userNameProvider;
+};
+
+static PasswdHomeCache& passwdHomeCache() {
+	// Intentionally never destroyed
+	static PasswdHomeCache* cache = new PasswdHomeCache();
+	return *cache;
+}
+
+/**
+ * Looks up an entry in the passwd database. lookup calls getpwuid_r() or getpwnam_r() with the given buffer.
+ * A thread local buffer is reused between calls so only the first lookup on a thread allocates it.
+ * The entry points into that buffer and is valid until the next lookup on the same thread.
+ * @return The entry or nullptr if there is none. ec will then be set.
+ */
+template <class Lookup>
+static struct passwd* lookupPasswd(struct passwd& pwd, Lookup lookup, std::error_code& ec) {
+	static thread_local std::vector<char> buffer;
+	if (buffer.empty()) {
+		long bufsize = sysconf(_SC_GETPW_R_SIZE_MAX);
+		if (bufsize < 1) {
+			bufsize = 16384;
+		}
+		buffer.resize(bufsize);
+	}
+	struct passwd* pw = nullptr;
+	PLATFORMFOLDERS_STAT_ADD(passwdLookups);
+	int error_code = lookup(&pwd, buffer.data(), buffer.size(), &pw);
+	while (error_code == ERANGE) {
+		// The buffer was too small. Try again with a larger buffer.
+		buffer.resize(buffer.size()*2);
+		error_code = lookup(&pwd, buffer.data(), buffer.size(), &pw);
+	}
+	if (error_code) {
+		ec = std::error_code(error_code, std::generic_category());
+		return nullptr;
+	}
+	if (!pw) {
+		ec = std::make_error_code(std::errc::no_such_file_or_directory);
+	}
+	return pw;
+}
+
+/**
+ * Looks up the home directory of uid in the passwd database.
+ * @return false if there is no home directory for uid. ec will then be set.
+ */
+static bool lookupPasswdHome(uid_t uid, std::string& home, std::error_code& ec) {
+	struct passwd pwd;
+	struct passwd* pw = lookupPasswd(pwd, [uid](struct passwd* entry, char* buffer, std::size_t size, struct passwd** result) {
+		return getpwuid_r(uid, entry, buffer, size, result);
+	}, ec);
+	if (!pw) {
+		return false;
+	}
+	if (!pw->pw_dir) {
+		// An entry without a home directory
+		ec = std::make_error_code(std::errc::no_such_file_or_directory);
+		return false;
+	}
+	home = pw->pw_dir;
+	return true;
+}
+
+/**
+ * Looks up the uid of a login name in the passwd database.
+ * @return false if there is no such user. ec will then be set.
+ */
+static bool lookupPasswdUid(const std::string& userName, unsigned long& uid, std::error_code& ec) {
+	struct passwd pwd;
+	struct passwd* pw = lookupPasswd(pwd, [&userName](struct passwd* entry, char* buffer, std::size_t size, struct passwd** result) {
+		return getpwnam_r(userName.c_str(), entry, buffer, size, result);
+	}, ec);
+	if (!pw) {
+		return false;
+	}
+	uid = pw->pw_uid;
+	return true;
+}
+
+/**
+ * Returns the cached passwd home directory for uid. It is looked up if the uid or effective uid has changed.
+ * The entry stays alive for as long as the caller holds it, even if it is replaced meanwhile.
+ * @return nullptr if the lookup failed. ec will then be set. Failures are not cached.
+ */
+static std::shared_ptr<const PasswdHome> cachedPasswdHome(uid_t uid, std::error_code& ec) {
+	PasswdHomeCache& cache = passwdHomeCache();
+	uid_t euid = geteuid();
+	std::shared_ptr<const PasswdHome> entry = std::atomic_load(&cache.current);
+	if (entry && entry->uid == uid && entry->euid == euid) {
+		PLATFORMFOLDERS_STAT_ADD(passwdCacheHits);
+		return entry;
+	}
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	entry = std::atomic_load(&cache.current);
+	if (entry && entry->uid == uid && entry->euid == euid) {
+		return entry;
+	}
+	std::shared_ptr<PasswdHome> created = std::make_shared<PasswdHome>();
+	created->uid = uid;
+	created->euid = euid;
+	if (cache.provider) {
+		if (!cache.provider(uid, created->home, ec)) {
+			return nullptr;
+		}
+	}
+	else if (!lookupPasswdHome(uid, created->home, ec)) {
+		return nullptr;
+	}
+	entry = created;
+	std::atomic_store(&cache.current, entry);
+	return entry;
+}
+
+static void invalidatePasswdHome() {
+	PasswdHomeCache& cache = passwdHomeCache();
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	std::atomic_store(&cache.current, std::shared_ptr<const PasswdHome>());
+}
+
+namespace sago {
+
+void setPasswdProvider(PasswdProvider provider) {
+	{
+		PasswdHomeCache& cache = passwdHomeCache();
+		std::lock_guard<std::mutex> lock(cache.mutex);
+		cache.provider = provider;
+	}
+	invalidateFolderCache();
+}
+
+void setUserNameProvider(UserNameProvider provider) {
+	{
+		PasswdHomeCache& cache = passwdHomeCache();
+		std::lock_guard<std::mutex> lock(cache.mutex);
+		cache.userNameProvider = provider;
+	}
+	invalidateFolderCache();
+}
+
+}  // namespace sago
+
 namespace sago {
 namespace internal {
 
@@ -44,45 +660,113 @@ namespace internal {
  * Retrives the effective user's home dir.
  * If the user is running as root we ignore the HOME environment. It works badly with sudo.
  * Writing to $HOME as root implies security concerns that a multiplatform program cannot be assumed to handle.
+ * The passwd lookup is cached until the uid changes or sago::invalidateFolderCache() is called.
  * @return The home directory. HOME environment is respected for non-root users if it exists.
  */
+std::string getHome(std::error_code& ec) noexcept {
+	ec.clear();
+	return noThrow(ec, [&ec]() -> std::string {
+		PLATFORMFOLDERS_STAT_TIMER(getHome);
+		std::shared_ptr<const sago::Environment> environment = sago::getEnvironment();
+		const sago::Environment& env = *environment;
+		uid_t uid = env.getUid();
+		const char* homeEnv = env.get(sago::Environment::Home);
+		if ( uid != 0 && homeEnv) {
+			//We only acknowlegde HOME if not root.
+			return homeEnv;
+		}
+		std::shared_ptr<const PasswdHome> entry = cachedPasswdHome(uid, ec);
+		return entry ? entry->home : std::string();
+	});
+}
+
+bool lookupHome(unsigned long uid, std::string& home, std::error_code& ec) noexcept {
+	ec.clear();
+	return noThrow(ec, [uid, &home, &ec]() {
+		PasswdProvider provider;
+		{
+			PasswdHomeCache& cache = passwdHomeCache();
+			std::lock_guard<std::mutex> lock(cache.mutex);
+			provider = cache.provider;
+		}
+		if (provider) {
+			return provider(uid, home, ec);
+		}
+		return lookupPasswdHome(static_cast<uid_t>(uid), home, ec);
+	});
+}
+
+bool lookupUid(const std::string& userName, unsigned long& uid, std::error_code& ec) noexcept {
+	ec.clear();
+	return noThrow(ec, [&userName, &uid, &ec]() {
+		UserNameProvider provider;
+		{
+			PasswdHomeCache& cache = passwdHomeCache();
+			std::lock_guard<std::mutex> lock(cache.mutex);
+			provider = cache.userNameProvider;
+		}
+		if (provider) {
+			return provider(userName, uid, ec);
+		}
+		return lookupPasswdUid(userName, uid, ec);
+	});
+}
+
 std::string getHome() {
-	std::string res;
-	int uid = getuid();
-	const char* homeEnv = std::getenv("HOME");
-	if ( uid != 0 && homeEnv) {
-		//We only acknowlegde HOME if not root.
-		res = homeEnv;
-		return res;
-	}
-	struct passwd* pw = nullptr;
-	struct passwd pwd;
-	long bufsize = sysconf(_SC_GETPW_R_SIZE_MAX);
-	if (bufsize < 1) {
-		bufsize = 16384;
+	std::error_code ec;
+	std::string home = getHome(ec);
+	if (ec) {
+		throwError(ec, "Unable to find the home directory in the passwd database");
 	}
-	std::vector<char> buffer;
-	buffer.resize(bufsize);
-	int error_code = getpwuid_r(uid, &pwd, buffer.data(), buffer.size(), &pw);
-	while (error_code == ERANGE) {
-		// The buffer was too small. Try again with a larger buffer.
-		bufsize *= 2;
-		buffer.resize(bufsize);
-		error_code = getpwuid_r(uid, &pwd, buffer.data(), buffer.size(), &pw);
+	return home;
+}
+
+}  // namesapce internal
+}  // namespace sago
+
+/**
+ * Same as sago::internal::getHome() but writes to a buffer instead of returning a string.
+ * Only the first passwd lookup allocates.
+ * @return false if the home directory could not be found. ec will then be set.
+ */
+static bool appendHome(const sago::Environment& env, PathBuffer& path, std::error_code& ec) {
+	uid_t uid = env.getUid();
+	const char* homeEnv = env.get(sago::Environment::Home);
+	if ( uid != 0 && homeEnv) {
+		path.append(homeEnv);
+		return true;
 	}
-	if (error_code) {
-		throw std::runtime_error("Unable to get passwd struct.");
+	std::shared_ptr<const PasswdHome> entry = noThrow(ec, [uid, &ec]() {
+		return cachedPasswdHome(uid, ec);
+	});
+	if (!entry) {
+		return false;
 	}
-	const char* tempRes = pw->pw_dir;
-	if (!tempRes) {
-		throw std::runtime_error("User has no home directory");
+	path.append(entry->home.data(), entry->home.size());
+	return true;
+}
+
+#ifdef __APPLE__
+static std::size_t getHomeRelative(const char* relativePath, char* buffer, std::size_t bufferSize, std::error_code& ec) {
+	ec.clear();
+	PathBuffer path(buffer, bufferSize);
+	std::shared_ptr<const sago::Environment> environment = sago::getEnvironment();
+	const sago::Environment& env = *environment;
+	if (!appendHome(env, path, ec)) {
+		return 0;
 	}
-	res = tempRes;
-	return res;
+	path.append(relativePath);
+	return path.finish(ec);
 }
 
-}  // namesapce internal
-}  // namespace sago
+static std::string getHomeRelative(const char* relativePath, std::error_code& ec) {
+	std::string home = sago::internal::getHome(ec);
+	if (ec) {
+		return std::string();
+	}
+	return home + relativePath;
+}
+#endif
 
 #endif
 
@@ -132,306 +816,1175 @@ public:
 	}
 };
 
+static std::string GetKnownWindowsFolder(REFKNOWNFOLDERID folderId, std::error_code& ec) {
+	LPWSTR wszPath = NULL;
+	HRESULT hr;
+	hr = SHGetKnownFolderPath(folderId, KF_FLAG_CREATE, NULL, &wszPath);
+	FreeCoTaskMemory scopeBoundMemory(wszPath);
+
+	if (!SUCCEEDED(hr)) {
+		ec = std::error_code(hr, std::system_category());
+		return std::string();
+	}
+	// The size includes the terminating null character
+	int actualSize = WideCharToMultiByte(CP_UTF8, 0, wszPath, -1, nullptr, 0, nullptr, nullptr);
+	if (actualSize <= 0) {
+		ec = std::error_code(GetLastError(), std::system_category());
+		return std::string();
+	}
+	std::vector<char> buffer(actualSize);
+	WideCharToMultiByte(CP_UTF8, 0, wszPath, -1, &buffer[0], actualSize, nullptr, nullptr);
+	return std::string(buffer.data(), actualSize - 1);
+}
+
 static std::string GetKnownWindowsFolder(REFKNOWNFOLDERID folderId, const char* errorMsg) {
+	std::error_code ec;
+	std::string folder = GetKnownWindowsFolder(folderId, ec);
+	if (ec) {
+		throwError(ec, errorMsg);
+	}
+	return folder;
+}
+
+static std::size_t GetKnownWindowsFolder(REFKNOWNFOLDERID folderId, char* buffer, std::size_t bufferSize, std::error_code& ec) {
+	ec.clear();
+	if (bufferSize > 0) {
+		buffer[0] = '\0';
+	}
 	LPWSTR wszPath = NULL;
 	HRESULT hr;
 	hr = SHGetKnownFolderPath(folderId, KF_FLAG_CREATE, NULL, &wszPath);
 	FreeCoTaskMemory scopeBoundMemory(wszPath);
 
 	if (!SUCCEEDED(hr)) {
-		throw std::runtime_error(errorMsg);
+		ec = std::error_code(hr, std::system_category());
+		return 0;
+	}
+	// The size includes the terminating null character
+	int actualSize = WideCharToMultiByte(CP_UTF8, 0, wszPath, -1, nullptr, 0, nullptr, nullptr);
+	if (actualSize <= 0) {
+		ec = std::error_code(GetLastError(), std::system_category());
+		return 0;
+	}
+	if (static_cast<std::size_t>(actualSize) > bufferSize) {
+		ec = std::make_error_code(std::errc::result_out_of_range);
+		return actualSize - 1;
+	}
+	WideCharToMultiByte(CP_UTF8, 0, wszPath, -1, buffer, actualSize, nullptr, nullptr);
+	return actualSize - 1;
+}
+
+static std::string GetAppData(std::error_code& ec) {
+	return GetKnownWindowsFolder(FOLDERID_RoamingAppData, ec);
+}
+
+static std::string GetAppDataCommon(std::error_code& ec) {
+	return GetKnownWindowsFolder(FOLDERID_ProgramData, ec);
+}
+
+static void appendCommonAppData(std::vector<std::string>& homes, int options, std::error_code& ec) {
+	std::string common = GetAppDataCommon(ec);
+	if (ec) {
+		return;
+	}
+	if ((options & sago::FolderListRemoveDuplicates) && std::find(homes.begin(), homes.end(), common) != homes.end()) {
+		return;
+	}
+	homes.push_back(common);
+}
+
+static std::string GetAppDataLocal(std::error_code& ec) {
+	return GetKnownWindowsFolder(FOLDERID_LocalAppData, ec);
+}
+#elif defined(__APPLE__)
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+//Typically Linux. For easy reading the comments will just say Linux but should work with most *nixes
+
+static bool checkAbsolute(const char* envValue, std::error_code& ec) {
+	if (envValue[0] != '/') {
+		PLATFORMFOLDERS_STAT_ADD(relativePathErrors);
+		ec = std::make_error_code(std::errc::invalid_argument);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Throws for a failed getLinuxFolderDefault(). A relative value is searched for in the variables from first to last.
+ */
+[[noreturn]] static void throwLinuxFolderError(const std::error_code& ec, sago::Environment::Variable first, sago::Environment::Variable last) {
+	if (ec == std::errc::invalid_argument) {
+		std::shared_ptr<const sago::Environment> environment = sago::getEnvironment();
+		const sago::Environment& env = *environment;
+		for (int i = first; i <= last; ++i) {
+			sago::Environment::Variable variable = static_cast<sago::Environment::Variable>(i);
+			const char* envValue = env.get(variable);
+			if (envValue && envValue[0] != '/') {
+				char buffer[200];
+				std::snprintf(buffer, sizeof(buffer), "Environment \"%s\" does not start with an '/'. XDG specifies that the value must be absolute. The current value is: \"%s\"", sago::Environment::name(variable), envValue);
+				throwError(ec, buffer);
+			}
+		}
+	}
+	throwError(ec, "Unable to find the home directory in the passwd database");
+}
+
+static std::string getLinuxFolderDefault(const sago::Environment& env, sago::Environment::Variable variable, const char* defaultRelativePath, const std::string& home, std::error_code& ec) {
+	const char* envValue = env.get(variable);
+	if (envValue) {
+		if (!checkAbsolute(envValue, ec)) {
+			return std::string();
+		}
+		return envValue;
+	}
+	return home + "/" + defaultRelativePath;
+}
+
+static std::string getLinuxFolderDefault(sago::Environment::Variable variable, const char* defaultRelativePath, std::error_code& ec) {
+	PLATFORMFOLDERS_STAT_ADD(lookups);
+	std::shared_ptr<const sago::Environment> environment = sago::getEnvironment();
+	const sago::Environment& env = *environment;
+	const char* envValue = env.get(variable);
+	if (envValue) {
+		if (!checkAbsolute(envValue, ec)) {
+			return std::string();
+		}
+		return envValue;
+	}
+	std::string home = sago::internal::getHome(ec);
+	if (ec) {
+		return std::string();
+	}
+	return home + "/" + defaultRelativePath;
+}
+
+static std::size_t getLinuxFolderDefault(sago::Environment::Variable variable, const char* defaultRelativePath, char* buffer, std::size_t bufferSize, std::error_code& ec) {
+	PLATFORMFOLDERS_STAT_ADD(lookups);
+	ec.clear();
+	PathBuffer path(buffer, bufferSize);
+	std::shared_ptr<const sago::Environment> environment = sago::getEnvironment();
+	const sago::Environment& env = *environment;
+	const char* tempRes = env.get(variable);
+	if (tempRes) {
+		if (!checkAbsolute(tempRes, ec)) {
+			return 0;
+		}
+		path.append(tempRes);
+		return path.finish(ec);
+	}
+	if (!appendHome(env, path, ec)) {
+		return 0;
+	}
+	path.append("/", 1);
+	path.append(defaultRelativePath);
+	return path.finish(ec);
+}
+
+static void appendExtraFolders(const sago::Environment& env, sago::Environment::Variable variable, const char* defaultValue, std::vector<std::string>& folders, int options) {
+	const char* envValue = env.get(variable);
+	if (!envValue) {
+		envValue = defaultValue;
 	}
-	return sago::internal::win32_utf16_to_utf8(wszPath);
+	sago::internal::appendExtraFoldersTokenizer(sago::Environment::name(variable), envValue, folders, options);
 }
 
-static std::string GetAppData() {
-	return GetKnownWindowsFolder(FOLDERID_RoamingAppData, "RoamingAppData could not be found");
+#endif
+
+
+namespace sago {
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+namespace {
+
+/**
+ * A set of paths that points into existing strings. Used to remove duplicates without allocating for every path.
+ * Open addressing with linear probing. The size is fixed at construction.
+ */
+class PathSet {
+public:
+	explicit PathSet(std::size_t maxEntries) {
+		std::size_t capacity = 0;
+		if (maxEntries > 0) {
+			capacity = 16;
+			while (capacity < maxEntries * 2) {
+				capacity *= 2;
+			}
+		}
+		slots.resize(capacity);
+	}
+	/**
+	 * @return false if the path was already in the set
+	 */
+	bool insert(const char* data, std::size_t size) {
+		std::size_t mask = slots.size() - 1;
+		for (std::size_t i = hash(data, size) & mask; ; i = (i + 1) & mask) {
+			Slot& slot = slots[i];
+			if (!slot.data) {
+				slot.data = data;
+				slot.size = size;
+				return true;
+			}
+			if (slot.size == size && std::memcmp(slot.data, data, size) == 0) {
+				return false;
+			}
+		}
+	}
+private:
+	struct Slot {
+		const char* data = nullptr;
+		std::size_t size = 0;
+	};
+	static std::size_t hash(const char* data, std::size_t size) {
+		// FNV-1a
+		std::size_t h = 2166136261u;
+		for (std::size_t i = 0; i < size; ++i) {
+			h = (h ^ static_cast<unsigned char>(data[i])) * 16777619u;
+		}
+		return h;
+	}
+	std::vector<Slot> slots;
+};
+
+// "/usr/share//" becomes "/usr/share". "/" stays "/".
+std::size_t withoutTrailingSlashes(const char* path, std::size_t length) {
+	while (length > 1 && path[length - 1] == '/') {
+		--length;
+	}
+	return length;
+}
+
+}  // namespace
+
+namespace internal {
+void appendExtraFoldersTokenizer(const char* envName, const char* envValue, std::vector<std::string>& folders, int options) {
+	const char* end = envValue + std::strlen(envValue);
+	const bool normalize = (options & FolderListNormalizeTrailingSlash) != 0;
+	const bool removeDuplicates = (options & FolderListRemoveDuplicates) != 0;
+	// Reserving up front means that the strings in folders do not move while PathSet points into them
+	std::size_t maxTokens = std::count(envValue, end, ':') + 1;
+	folders.reserve(folders.size() + maxTokens);
+	PathSet seen(removeDuplicates ? folders.size() + maxTokens : 0);
+	if (removeDuplicates) {
+		for (std::size_t i = 0; i < folders.size(); ++i) {
+			std::size_t length = folders[i].size();
+			if (normalize) {
+				length = withoutTrailingSlashes(folders[i].data(), length);
+			}
+			seen.insert(folders[i].data(), length);
+		}
+	}
+	for (const char* pos = envValue; pos <= end; ) {
+		const char* separator = static_cast<const char*>(std::memchr(pos, ':', end - pos));
+		if (!separator) {
+			separator = end;
+		}
+		std::size_t length = separator - pos;
+		if (length == 0) {
+			// Empty entries are simply ignored
+		}
+		else if (*pos != '/') {
+			//Unless the system is wrongly configured this should never happen... But of course some systems will be incorectly configured.
+			//The XDG documentation indicates that the folder should be ignored but that the program should continue.
+			reportDiagnostic(Diagnostic::RelativePathInList, "Skipping path \"%.*s\" in \"%s\" because it does not start with a \"/\"", static_cast<int>(length), pos, envName);
+		}
+		else {
+			if (normalize) {
+				length = withoutTrailingSlashes(pos, length);
+			}
+			if (!removeDuplicates || seen.insert(pos, length)) {
+				folders.push_back(std::string(pos, length));
+			}
+		}
+		pos = separator + 1;
+	}
+}
+
+static bool isShellNameChar(char c) {
+	return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+/**
+ * Consumes "$HOME" or "${HOME}" at pos if it is there.
+ */
+static bool consumeHomeVariable(const char*& pos, const char* end) {
+	std::size_t left = end - pos;
+	if (left >= 5 && std::memcmp(pos, "$HOME", 5) == 0 && (left == 5 || !isShellNameChar(pos[5]))) {
+		pos += 5;
+		return true;
+	}
+	if (left >= 7 && std::memcmp(pos, "${HOME}", 7) == 0) {
+		pos += 7;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Parses a single shell word like the value part of FOO="bar".
+ * Double quotes, single quotes and backslash escapes are handled like the shell does.
+ * A $HOME at the very start of the value is not copied. relativeToHome is set instead.
+ * No other variables are expanded.
+ * @return false if a quote was not terminated before end
+ */
+static bool parseShellWord(const char*& pos, const char* end, std::string& value, bool& relativeToHome) {
+	value.clear();
+	relativeToHome = false;
+	bool inDoubleQuotes = false;
+	while (pos < end) {
+		if (value.empty() && !relativeToHome && *pos == '$' && consumeHomeVariable(pos, end)) {
+			relativeToHome = true;
+			continue;
+		}
+		if (inDoubleQuotes) {
+			const char* run = pos;
+			while (pos < end && *pos != '"' && *pos != '\\' && *pos != '$') {
+				++pos;
+			}
+			value.append(run, pos);
+			if (pos == end) {
+				break;
+			}
+			if (*pos == '"') {
+				inDoubleQuotes = false;
+				++pos;
+			}
+			else if (*pos == '\\' && pos + 1 < end && std::strchr("\"\\$`", pos[1])) {
+				value += pos[1];
+				pos += 2;
+			}
+			else {
+				value += *pos;
+				++pos;
+			}
+			continue;
+		}
+		char c = *pos;
+		if (c == ' ' || c == '\t' || c == '\r') {
+			break;
+		}
+		if (c == '"') {
+			inDoubleQuotes = true;
+			++pos;
+		}
+		else if (c == '\'') {
+			const char* close = static_cast<const char*>(std::memchr(pos + 1, '\'', end - pos - 1));
+			if (!close) {
+				return false;
+			}
+			value.append(pos + 1, close);
+			pos = close + 1;
+		}
+		else if (c == '\\' && pos + 1 < end) {
+			value += pos[1];
+			pos += 2;
+		}
+		else {
+			value += c;
+			++pos;
+		}
+	}
+	return !inDoubleQuotes;
+}
+
+void parseUserDirs(const char* filename, const char* data, std::size_t size, const UserDirsCallback& onEntry) {
+	const char* pos = data;
+	const char* end = data + size;
+	// Reused for every value. onEntry may swap it with an empty string.
+	std::string value;
+	while (pos < end) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+		if (!lineEnd) {
+			lineEnd = end;
+		}
+		const char* lineStart = pos;
+		pos = lineEnd + 1;
+		const char* p = lineStart;
+		while (p < lineEnd && (*p == ' ' || *p == '\t')) {
+			++p;
+		}
+		const char* key = p;
+		while (p < lineEnd && isShellNameChar(*p)) {
+			++p;
+		}
+		std::size_t keyLength = p - key;
+		// Everything that is not a XDG_*_DIR assignment (comments, empty lines etc.) is silently ignored
+		if (keyLength < 8 || std::memcmp(key, "XDG_", 4) != 0 || std::memcmp(p - 4, "_DIR", 4) != 0) {
+			continue;
+		}
+		const char* error = nullptr;
+		bool relativeToHome = false;
+		if (p == lineEnd || *p != '=') {
+			error = "Expected '=' after the name";
+		}
+		else {
+			++p;
+			if (!parseShellWord(p, lineEnd, value, relativeToHome)) {
+				error = "Unterminated quote";
+			}
+		}
+		if (error) {
+			reportDiagnostic(Diagnostic::InvalidUserDirsLine, "WARNING: Failed to process \"%.*s\" from \"%s\". Error: %s", static_cast<int>(lineEnd - lineStart), lineStart, filename, error);
+			continue;
+		}
+		onEntry(key, keyLength, value, relativeToHome);
+	}
+}
+
+void parseUserDirsFile(const std::string& filename, const UserDirsCallback& onEntry) {
+	int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		// It is normal for the file to not exist
+		PLATFORMFOLDERS_STAT_ADD(userDirsReads);
+		return;
+	}
+	parseUserDirsFile(filename, fd, onEntry);
+	close(fd);
+}
+
+void parseUserDirsFile(const std::string& filename, int fd, const UserDirsCallback& onEntry) {
+	PLATFORMFOLDERS_STAT_ADD(userDirsReads);
+	// user-dirs.dirs is normally well below 1 KiB and will be read in one go without allocating
+	char stackBuffer[4096];
+	std::vector<char> heapBuffer;
+	char* buffer = stackBuffer;
+	std::size_t capacity = sizeof(stackBuffer);
+	std::size_t size = 0;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= capacity) {
+		heapBuffer.resize(st.st_size + 1);
+		buffer = heapBuffer.data();
+		capacity = heapBuffer.size();
+	}
+	for (;;) {
+		if (size == capacity) {
+			// The file grew while we were reading it
+			heapBuffer.resize(capacity * 2);
+			if (buffer == stackBuffer) {
+				std::memcpy(heapBuffer.data(), stackBuffer, size);
+			}
+			buffer = heapBuffer.data();
+			capacity = heapBuffer.size();
+		}
+		ssize_t bytesRead = read(fd, buffer + size, capacity - size);
+		if (bytesRead < 0 && errno == EINTR) {
+			continue;
+		}
+		if (bytesRead <= 0) {
+			break;
+		}
+		size += bytesRead;
+	}
+	parseUserDirs(filename.c_str(), buffer, size, onEntry);
+}
+}
+#endif
+
+namespace {
+
+#ifdef _WIN32
+// Indexed by BaseDir
+const char* const baseDirErrors[] = {
+	"RoamingAppData could not be found",
+	"RoamingAppData could not be found",
+	"LocalAppData could not be found",
+	"LocalAppData could not be found",
+};
+#elif !defined(__APPLE__)
+// Indexed by BaseDir
+const Environment::Variable baseDirVariables[] = {
+	Environment::XdgDataHome,
+	Environment::XdgConfigHome,
+	Environment::XdgCacheHome,
+	Environment::XdgStateHome,
+};
+#endif
+
+[[noreturn]] void throwBaseDirError(BaseDir dir, const std::error_code& ec) {
+#ifdef _WIN32
+	throwError(ec, baseDirErrors[static_cast<std::size_t>(dir)]);
+#elif defined(__APPLE__)
+	(void)dir;
+	throwError(ec, "Unable to find the home directory in the passwd database");
+#else
+	Environment::Variable variable = baseDirVariables[static_cast<std::size_t>(dir)];
+	throwLinuxFolderError(ec, variable, variable);
+#endif
+}
+
+/**
+ * Throws for a failure to resolve the user folders
+ */
+[[noreturn]] void throwResolveError(const std::error_code& ec) {
+	// Only the config folder and the home folder are needed on Linux, only the home folder on macOS
+	throwBaseDirError(BaseDir::Config, ec);
+}
+
+}  // namespace
+
+std::string getDataHome(std::error_code& ec) noexcept {
+	ec.clear();
+	return noThrow(ec, [&ec]() {
+#ifdef _WIN32
+		return GetAppData(ec);
+#elif defined(__APPLE__)
+		return getHomeRelative("/Library/Application Support", ec);
+#else
+		return getLinuxFolderDefault(Environment::XdgDataHome, ".local/share", ec);
+#endif
+	});
 }
 
-static std::string GetAppDataCommon() {
-	return GetKnownWindowsFolder(FOLDERID_ProgramData, "ProgramData could not be found");
+std::string getConfigHome(std::error_code& ec) noexcept {
+	ec.clear();
+	return noThrow(ec, [&ec]() {
+#ifdef _WIN32
+		return GetAppData(ec);
+#elif defined(__APPLE__)
+		return getHomeRelative("/Library/Application Support", ec);
+#else
+		return getLinuxFolderDefault(Environment::XdgConfigHome, ".config", ec);
+#endif
+	});
 }
 
-static std::string GetAppDataLocal() {
-	return GetKnownWindowsFolder(FOLDERID_LocalAppData, "LocalAppData could not be found");
+std::string getCacheDir(std::error_code& ec) noexcept {
+	ec.clear();
+	return noThrow(ec, [&ec]() {
+#ifdef _WIN32
+		return GetAppDataLocal(ec);
+#elif defined(__APPLE__)
+		return getHomeRelative("/Library/Caches", ec);
+#else
+		return getLinuxFolderDefault(Environment::XdgCacheHome, ".cache", ec);
+#endif
+	});
 }
+
+std::string getStateDir(std::error_code& ec) noexcept {
+	ec.clear();
+	return noThrow(ec, [&ec]() {
+#ifdef _WIN32
+		return GetAppDataLocal(ec);
 #elif defined(__APPLE__)
+		return getHomeRelative("/Library/Application Support", ec);
 #else
-#include <map>
-#include <fstream>
-#include <sys/types.h>
-// For strlen and strtok
-#include <cstring>
-#include <sstream>
-//Typically Linux. For easy reading the comments will just say Linux but should work with most *nixes
+		return getLinuxFolderDefault(Environment::XdgStateHome, ".local/state", ec);
+#endif
+	});
+}
 
-static void throwOnRelative(const char* envName, const char* envValue) {
-	if (envValue[0] != '/') {
-		char buffer[200];
-		std::snprintf(buffer, sizeof(buffer), "Environment \"%s\" does not start with an '/'. XDG specifies that the value must be absolute. The current value is: \"%s\"", envName, envValue);
-		throw std::runtime_error(buffer);
+std::string getDataHome() {
+	std::error_code ec;
+	std::string folder = getDataHome(ec);
+	if (ec) {
+		throwBaseDirError(BaseDir::Data, ec);
 	}
+	return folder;
 }
 
-
-
-static std::string getLinuxFolderDefault(const char* envName, const char* defaultRelativePath) {
-	std::string res;
-	const char* tempRes = std::getenv(envName);
-	if (tempRes) {
-		throwOnRelative(envName, tempRes);
-		res = tempRes;
-		return res;
+std::string getConfigHome() {
+	std::error_code ec;
+	std::string folder = getConfigHome(ec);
+	if (ec) {
+		throwBaseDirError(BaseDir::Config, ec);
 	}
-	res = sago::internal::getHome() + "/" + defaultRelativePath;
-	return res;
+	return folder;
 }
 
-static void appendExtraFolders(const char* envName, const char* defaultValue, std::vector<std::string>& folders) {
-	const char* envValue = std::getenv(envName);
-	if (!envValue) {
-		envValue = defaultValue;
+std::string getCacheDir() {
+	std::error_code ec;
+	std::string folder = getCacheDir(ec);
+	if (ec) {
+		throwBaseDirError(BaseDir::Cache, ec);
 	}
-	sago::internal::appendExtraFoldersTokenizer(envName, envValue, folders);
+	return folder;
 }
 
-#endif
-
-
-namespace sago {
-
-#if !defined(_WIN32) && !defined(__APPLE__)
-namespace internal {
-void appendExtraFoldersTokenizer(const char* envName, const char* envValue, std::vector<std::string>& folders) {
-	std::stringstream ss(envValue);
-	std::string value;
-	while (std::getline(ss, value, ':')) {
-		if (value[0] == '/') {
-			folders.push_back(value);
-		}
-		else {
-			//Unless the system is wrongly configured this should never happen... But of course some systems will be incorectly configured.
-			//The XDG documentation indicates that the folder should be ignored but that the program should continue.
-			std::cerr << "Skipping path \"" << value << "\" in \"" << envName << "\" because it does not start with a \"/\"\n";
-		}
+std::string getStateDir() {
+	std::error_code ec;
+	std::string folder = getStateDir(ec);
+	if (ec) {
+		throwBaseDirError(BaseDir::State, ec);
 	}
+	return folder;
 }
-}
-#endif
 
-std::string getDataHome() {
+std::size_t getDataHome(char* buffer, std::size_t bufferSize, std::error_code& ec) noexcept {
 #ifdef _WIN32
-	return GetAppData();
+	return GetKnownWindowsFolder(FOLDERID_RoamingAppData, buffer, bufferSize, ec);
 #elif defined(__APPLE__)
-	return sago::internal::getHome()+"/Library/Application Support";
+	return getHomeRelative("/Library/Application Support", buffer, bufferSize, ec);
 #else
-	return getLinuxFolderDefault("XDG_DATA_HOME", ".local/share");
+	return getLinuxFolderDefault(Environment::XdgDataHome, ".local/share", buffer, bufferSize, ec);
 #endif
 }
 
-std::string getConfigHome() {
+std::size_t getConfigHome(char* buffer, std::size_t bufferSize, std::error_code& ec) noexcept {
 #ifdef _WIN32
-	return GetAppData();
+	return GetKnownWindowsFolder(FOLDERID_RoamingAppData, buffer, bufferSize, ec);
 #elif defined(__APPLE__)
-	return sago::internal::getHome()+"/Library/Application Support";
+	return getHomeRelative("/Library/Application Support", buffer, bufferSize, ec);
 #else
-	return getLinuxFolderDefault("XDG_CONFIG_HOME", ".config");
+	return getLinuxFolderDefault(Environment::XdgConfigHome, ".config", buffer, bufferSize, ec);
 #endif
 }
 
-std::string getCacheDir() {
+std::size_t getCacheDir(char* buffer, std::size_t bufferSize, std::error_code& ec) noexcept {
 #ifdef _WIN32
-	return GetAppDataLocal();
+	return GetKnownWindowsFolder(FOLDERID_LocalAppData, buffer, bufferSize, ec);
 #elif defined(__APPLE__)
-	return sago::internal::getHome()+"/Library/Caches";
+	return getHomeRelative("/Library/Caches", buffer, bufferSize, ec);
 #else
-	return getLinuxFolderDefault("XDG_CACHE_HOME", ".cache");
+	return getLinuxFolderDefault(Environment::XdgCacheHome, ".cache", buffer, bufferSize, ec);
 #endif
 }
 
-std::string getStateDir() {
+std::size_t getStateDir(char* buffer, std::size_t bufferSize, std::error_code& ec) noexcept {
 #ifdef _WIN32
-	return GetAppDataLocal();
+	return GetKnownWindowsFolder(FOLDERID_LocalAppData, buffer, bufferSize, ec);
 #elif defined(__APPLE__)
-	return sago::internal::getHome()+"/Library/Application Support";
+	return getHomeRelative("/Library/Application Support", buffer, bufferSize, ec);
 #else
-	return getLinuxFolderDefault("XDG_STATE_HOME", ".local/state");
+	return getLinuxFolderDefault(Environment::XdgStateHome, ".local/state", buffer, bufferSize, ec);
 #endif
 }
 
 void appendAdditionalDataDirectories(std::vector<std::string>& homes) {
+	appendAdditionalDataDirectories(homes, FolderListDefault);
+}
+
+void appendAdditionalDataDirectories(std::vector<std::string>& homes, int options) {
+	std::error_code ec;
+	appendAdditionalDataDirectories(homes, options, ec);
+	if (ec) {
+		throwError(ec, "ProgramData could not be found");
+	}
+}
+
+void appendAdditionalDataDirectories(std::vector<std::string>& homes, int options, std::error_code& ec) noexcept {
+	ec.clear();
+	const std::size_t size = homes.size();
+	noThrow(ec, [&]() {
 #ifdef _WIN32
-	homes.push_back(GetAppDataCommon());
+		appendCommonAppData(homes, options, ec);
 #elif !defined(__APPLE__)
-	appendExtraFolders("XDG_DATA_DIRS", "/usr/local/share/:/usr/share/", homes);
+		appendExtraFolders(*getEnvironment(), Environment::XdgDataDirs, "/usr/local/share/:/usr/share/", homes, options);
 #endif
+	});
+	if (ec) {
+		homes.erase(homes.begin() + size, homes.end());
+	}
 }
 
 void appendAdditionalConfigDirectories(std::vector<std::string>& homes) {
+	appendAdditionalConfigDirectories(homes, FolderListDefault);
+}
+
+void appendAdditionalConfigDirectories(std::vector<std::string>& homes, int options) {
+	std::error_code ec;
+	appendAdditionalConfigDirectories(homes, options, ec);
+	if (ec) {
+		throwError(ec, "ProgramData could not be found");
+	}
+}
+
+void appendAdditionalConfigDirectories(std::vector<std::string>& homes, int options, std::error_code& ec) noexcept {
+	ec.clear();
+	const std::size_t size = homes.size();
+	noThrow(ec, [&]() {
 #ifdef _WIN32
-	homes.push_back(GetAppDataCommon());
+		appendCommonAppData(homes, options, ec);
 #elif !defined(__APPLE__)
-	appendExtraFolders("XDG_CONFIG_DIRS", "/etc/xdg", homes);
+		appendExtraFolders(*getEnvironment(), Environment::XdgConfigDirs, "/etc/xdg", homes, options);
 #endif
+	});
+	if (ec) {
+		homes.erase(homes.begin() + size, homes.end());
+	}
 }
 
-#if !defined(_WIN32) && !defined(__APPLE__)
-struct PlatformFolders::PlatformFoldersData {
-	std::map<std::string, std::string> folders;
+namespace {
+
+using sago::internal::folderCount;
+
+std::size_t folderIndex(Folder folder) {
+	return static_cast<std::size_t>(folder);
+}
+
+/**
+ * One set of resolved folders indexed by Folder.
+ */
+struct FolderSnapshot {
+	std::string folders[folderCount];
+	// Only used on Windows, where looking up a single known folder can fail. The error is reported when the folder is requested.
+	std::string errors[folderCount];
+	std::error_code errorCodes[folderCount];
 };
 
-static void PlatformFoldersAddFromFile(const std::string& filename, std::map<std::string, std::string>& folders) {
-	std::ifstream infile(filename.c_str());
-	std::string line;
-	while (std::getline(infile, line)) {
-		if (line.length() == 0 || line.at(0) == '#' || line.substr(0, 4) != "XDG_" || line.find("_DIR") == std::string::npos) {
-			continue;
-		}
-		try {
-			std::size_t splitPos = line.find('=');
-			std::string key = line.substr(0, splitPos);
-			std::size_t valueStart = line.find('"', splitPos);
-			std::size_t valueEnd = line.find('"', valueStart+1);
-			std::string value = line.substr(valueStart+1, valueEnd - valueStart - 1);
-			folders[key] = value;
+}  // namespace
+
+/**
+ * The resolved folders are published as immutable snapshots.
+ * Readers do an atomic load of the current snapshot and hold on to it while they copy a folder out of it.
+ * The first snapshot is built by the first reader that finds none. Only that reader holds the mutex.
+ * refresh() builds a new snapshot and swaps it in. A replaced snapshot is freed by the last reader
+ * that still holds it.
+ */
+struct PlatformFolders::PlatformFoldersData {
+	std::mutex mutex;
+	// Only accessed through std::atomic_load() and std::atomic_store()
+	std::shared_ptr<const FolderSnapshot> current;
+	// Null if the folders could not be resolved. ec will then be set.
+	std::shared_ptr<const FolderSnapshot> snapshot(std::error_code& ec) {
+		std::shared_ptr<const FolderSnapshot> s = std::atomic_load(&current);
+		if (s) {
+			return s;
 		}
-		catch (std::exception&  e) {
-			std::cerr << "WARNING: Failed to process \"" << line << "\" from \"" << filename << "\". Error: "<< e.what() << "\n";
-			continue;
+		return resolve(ec);
+	}
+	std::shared_ptr<const FolderSnapshot> resolve(std::error_code& ec);
+	void publish(std::shared_ptr<const FolderSnapshot> snapshot) {
+		std::lock_guard<std::mutex> lock(mutex);
+		std::atomic_store(&current, snapshot);
+	}
+};
+
+#ifdef _WIN32
+static void PlatformFoldersFillKnownFolder(FolderSnapshot& snapshot, Folder folder, REFKNOWNFOLDERID folderId, const char* errorMsg) {
+	std::size_t index = folderIndex(folder);
+	snapshot.folders[index] = GetKnownWindowsFolder(folderId, snapshot.errorCodes[index]);
+	if (snapshot.errorCodes[index]) {
+		snapshot.errors[index] = errorMsg;
+	}
+}
+
+static bool PlatformFoldersFillData(FolderSnapshot& snapshot, std::error_code&) {
+	PlatformFoldersFillKnownFolder(snapshot, Folder::Desktop, FOLDERID_Desktop, "Failed to find Desktop folder");
+	PlatformFoldersFillKnownFolder(snapshot, Folder::Documents, FOLDERID_Documents, "Failed to find My Documents folder");
+	PlatformFoldersFillKnownFolder(snapshot, Folder::Download, FOLDERID_Downloads, "Failed to find My Downloads folder");
+	PlatformFoldersFillKnownFolder(snapshot, Folder::Music, FOLDERID_Music, "Failed to find My Music folder");
+	PlatformFoldersFillKnownFolder(snapshot, Folder::Pictures, FOLDERID_Pictures, "Failed to find My Pictures folder");
+	PlatformFoldersFillKnownFolder(snapshot, Folder::Public, FOLDERID_Public, "Failed to find the Public folder");
+	PlatformFoldersFillKnownFolder(snapshot, Folder::Templates, FOLDERID_Templates, "Failed to find the Templates folder");
+	PlatformFoldersFillKnownFolder(snapshot, Folder::Videos, FOLDERID_Videos, "Failed to find My Video folder");
+	// Failed folders are reported when they are requested
+	return true;
+}
+#elif defined(__APPLE__)
+static void PlatformFoldersFillData(FolderSnapshot& snapshot, const std::string& home) {
+	for (std::size_t i = 0; i < folderCount; ++i) {
+		snapshot.folders[i] = home + sago::internal::folderTable[i].homeRelative;
+	}
+}
+
+static bool PlatformFoldersFillData(FolderSnapshot& snapshot, std::error_code& ec) {
+	std::string home = sago::internal::getHome(ec);
+	if (ec) {
+		return false;
+	}
+	PlatformFoldersFillData(snapshot, home);
+	return true;
+}
+#else
+// Null for entries that do not match a Folder. Nothing could read them, so they are skipped.
+static std::string* PlatformFoldersSlot(FolderSnapshot& snapshot, const char* key, std::size_t keyLength) {
+	for (std::size_t i = 0; i < folderCount; ++i) {
+		const char* xdgKey = sago::internal::folderTable[i].xdgKey;
+		if (std::strlen(xdgKey) == keyLength && std::memcmp(xdgKey, key, keyLength) == 0) {
+			return &snapshot.folders[i];
 		}
 	}
+	return nullptr;
 }
 
-static void PlatformFoldersFillData(std::map<std::string, std::string>& folders) {
-	folders["XDG_DOCUMENTS_DIR"] = "$HOME/Documents";
-	folders["XDG_DESKTOP_DIR"] = "$HOME/Desktop";
-	folders["XDG_DOWNLOAD_DIR"] = "$HOME/Downloads";
-	folders["XDG_MUSIC_DIR"] = "$HOME/Music";
-	folders["XDG_PICTURES_DIR"] = "$HOME/Pictures";
-	folders["XDG_PUBLICSHARE_DIR"] = "$HOME/Public";
-	folders["XDG_TEMPLATES_DIR"] = "$HOME/.Templates";
-	folders["XDG_VIDEOS_DIR"] = "$HOME/Videos";
-	PlatformFoldersAddFromFile( getConfigHome()+"/user-dirs.dirs", folders);
-	for (std::map<std::string, std::string>::iterator itr = folders.begin() ; itr != folders.end() ; ++itr ) {
-		std::string& value = itr->second;
-		if (value.compare(0, 5, "$HOME") == 0) {
-			value = sago::internal::getHome() + value.substr(5, std::string::npos);
+static void PlatformFoldersFillData(FolderSnapshot& snapshot, const std::string& home, const std::string& configHome) {
+	for (std::size_t i = 0; i < folderCount; ++i) {
+		snapshot.folders[i] = home + sago::internal::folderTable[i].homeRelative;
+	}
+	sago::internal::parseUserDirsFile(configHome+"/user-dirs.dirs", [&](const char* key, std::size_t keyLength, std::string& value, bool relativeToHome) {
+		std::string* slot = PlatformFoldersSlot(snapshot, key, keyLength);
+		if (!slot) {
+			return;
+		}
+		if (relativeToHome) {
+			slot->assign(home).append(value);
+		}
+		else {
+			// The parser reuses whatever string it gets back as scratch space
+			slot->swap(value);
 		}
+	});
+}
+
+static bool PlatformFoldersFillData(FolderSnapshot& snapshot, std::error_code& ec) {
+	std::string home = sago::internal::getHome(ec);
+	if (ec) {
+		return false;
+	}
+	std::string configHome = getConfigHome(ec);
+	if (ec) {
+		return false;
 	}
+	PlatformFoldersFillData(snapshot, home, configHome);
+	return true;
 }
 #endif
 
+std::shared_ptr<const FolderSnapshot> PlatformFolders::PlatformFoldersData::resolve(std::error_code& ec) {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::shared_ptr<const FolderSnapshot> s = std::atomic_load(&current);
+	if (s) {
+		// Another thread resolved it while we waited
+		return s;
+	}
+	PLATFORMFOLDERS_STAT_TIMER(resolve);
+	std::shared_ptr<FolderSnapshot> snapshot = std::make_shared<FolderSnapshot>();
+	if (!PlatformFoldersFillData(*snapshot, ec)) {
+		// Nothing is published, so the next call tries again
+		return std::shared_ptr<const FolderSnapshot>();
+	}
+	std::atomic_store(&current, std::shared_ptr<const FolderSnapshot>(snapshot));
+	return snapshot;
+}
+
 PlatformFolders::PlatformFolders() {
-#if !defined(_WIN32) && !defined(__APPLE__)
 	this->data = new PlatformFolders::PlatformFoldersData();
-	try {
-		PlatformFoldersFillData(data->folders);
-	}
-	catch (...) {
-		delete this->data;
-		throw;
+}
+
+void PlatformFolders::refresh(std::error_code& ec) noexcept {
+	ec.clear();
+	noThrow(ec, [this, &ec]() {
+		PLATFORMFOLDERS_STAT_TIMER(resolve);
+		std::shared_ptr<FolderSnapshot> snapshot = std::make_shared<FolderSnapshot>();
+		if (PlatformFoldersFillData(*snapshot, ec)) {
+			data->publish(snapshot);
+		}
+	});
+}
+
+void PlatformFolders::refresh() {
+	std::error_code ec;
+	refresh(ec);
+	if (ec) {
+		throwResolveError(ec);
 	}
-#endif
 }
 
 PlatformFolders::~PlatformFolders() {
-#if !defined(_WIN32) && !defined(__APPLE__)
 	delete this->data;
-#endif
+}
+
+std::string PlatformFolders::getFolder(Folder folder, std::error_code& ec) const noexcept {
+	ec.clear();
+	return noThrow(ec, [this, folder, &ec]() -> std::string {
+		// Holding the snapshot keeps it alive while the folder is copied, even if refresh() replaces it
+		std::shared_ptr<const FolderSnapshot> snapshot = data->snapshot(ec);
+		if (!snapshot) {
+			return std::string();
+		}
+		std::size_t index = folderIndex(folder);
+		if (snapshot->errorCodes[index]) {
+			ec = snapshot->errorCodes[index];
+			return std::string();
+		}
+		return snapshot->folders[index];
+	});
+}
+
+std::string PlatformFolders::getFolder(Folder folder) const {
+	std::error_code ec;
+	std::string result = getFolder(folder, ec);
+	if (ec) {
+		std::shared_ptr<const FolderSnapshot> snapshot = std::atomic_load(&data->current);
+		if (snapshot && !snapshot->errors[folderIndex(folder)].empty()) {
+			throwError(ec, snapshot->errors[folderIndex(folder)].c_str());
+		}
+		throwResolveError(ec);
+	}
+	return result;
 }
 
 std::string PlatformFolders::getDocumentsFolder() const {
-#ifdef _WIN32
-	return GetKnownWindowsFolder(FOLDERID_Documents, "Failed to find My Documents folder");
-#elif defined(__APPLE__)
-	return sago::internal::getHome()+"/Documents";
-#else
-	return data->folders["XDG_DOCUMENTS_DIR"];
-#endif
+	return getFolder(Folder::Documents);
 }
 
 std::string PlatformFolders::getDesktopFolder() const {
-#ifdef _WIN32
-	return GetKnownWindowsFolder(FOLDERID_Desktop, "Failed to find Desktop folder");
-#elif defined(__APPLE__)
-	return sago::internal::getHome()+"/Desktop";
-#else
-	return data->folders["XDG_DESKTOP_DIR"];
-#endif
+	return getFolder(Folder::Desktop);
 }
 
 std::string PlatformFolders::getPicturesFolder() const {
-#ifdef _WIN32
-	return GetKnownWindowsFolder(FOLDERID_Pictures, "Failed to find My Pictures folder");
-#elif defined(__APPLE__)
-	return sago::internal::getHome()+"/Pictures";
-#else
-	return data->folders["XDG_PICTURES_DIR"];
-#endif
+	return getFolder(Folder::Pictures);
 }
 
 std::string PlatformFolders::getPublicFolder() const {
-#ifdef _WIN32
-	return GetKnownWindowsFolder(FOLDERID_Public, "Failed to find the Public folder");
-#elif defined(__APPLE__)
-	return sago::internal::getHome()+"/Public";
-#else
-	return data->folders["XDG_PUBLICSHARE_DIR"];
-#endif
+	return getFolder(Folder::Public);
 }
 
 std::string PlatformFolders::getDownloadFolder1() const {
-#ifdef _WIN32
-	return GetKnownWindowsFolder(FOLDERID_Downloads, "Failed to find My Downloads folder");
-#elif defined(__APPLE__)
-	return sago::internal::getHome()+"/Downloads";
-#else
-	return data->folders["XDG_DOWNLOAD_DIR"];
-#endif
+	return getFolder(Folder::Download);
 }
 
 std::string PlatformFolders::getMusicFolder() const {
-#ifdef _WIN32
-	return GetKnownWindowsFolder(FOLDERID_Music, "Failed to find My Music folder");
-#elif defined(__APPLE__)
-	return sago::internal::getHome()+"/Music";
-#else
-	return data->folders["XDG_MUSIC_DIR"];
-#endif
+	return getFolder(Folder::Music);
 }
 
 std::string PlatformFolders::getVideoFolder() const {
+	return getFolder(Folder::Videos);
+}
+
+std::string PlatformFolders::getSaveGamesFolder1(std::error_code& ec) const noexcept {
 #ifdef _WIN32
-	return GetKnownWindowsFolder(FOLDERID_Videos, "Failed to find My Video folder");
-#elif defined(__APPLE__)
-	return sago::internal::getHome()+"/Movies";
+	//A dedicated Save Games folder was not introduced until Vista. For XP and older save games are most often saved in a normal folder named "My Games".
+	//Data that should not be user accessible should be placed under GetDataHome() instead
+	std::string documents = getFolder(Folder::Documents, ec);
+	if (ec) {
+		return std::string();
+	}
+	return noThrow(ec, [&documents]() {
+		return documents+"\\My Games";
+	});
 #else
-	return data->folders["XDG_VIDEOS_DIR"];
+	// Same as the data folder on macOS and Linux
+	return getDataHome(ec);
 #endif
 }
 
 std::string PlatformFolders::getSaveGamesFolder1() const {
+	std::error_code ec;
+	std::string folder = getSaveGamesFolder1(ec);
+	if (ec) {
 #ifdef _WIN32
-	//A dedicated Save Games folder was not introduced until Vista. For XP and older save games are most often saved in a normal folder named "My Games".
-	//Data that should not be user accessible should be placed under GetDataHome() instead
-	return GetKnownWindowsFolder(FOLDERID_Documents, "Failed to find My Documents folder")+"\\My Games";
-#elif defined(__APPLE__)
-	return sago::internal::getHome()+"/Library/Application Support";
+		getFolder(Folder::Documents);
+#endif
+		throwBaseDirError(BaseDir::Data, ec);
+	}
+	return folder;
+}
+
+namespace {
+
+/**
+ * Holds the PlatformFolders instance used by the free functions.
+ * invalidateFolderCache() only marks it as stale. The next reader refreshes it.
+ */
+struct FolderCache {
+	std::mutex mutex;
+	std::atomic<PlatformFolders*> instance;
+	std::atomic<bool> stale;
+	std::atomic<unsigned long long> generation;
+	FolderCache() : instance(nullptr), stale(false), generation(0) {}
+};
+
+FolderCache& folderCache() {
+	// Intentionally never destroyed so the free functions also work during static destruction
+	static FolderCache* cache = new FolderCache();
+	return *cache;
+}
+
+// Null if the folders could not be resolved. ec will then be set and the next call tries again.
+const PlatformFolders* cachedPlatformFolders(std::error_code& ec) {
+	PLATFORMFOLDERS_STAT_ADD(lookups);
+	FolderCache& cache = folderCache();
+	PlatformFolders* pf = cache.instance.load(std::memory_order_acquire);
+	if (pf && !cache.stale.load(std::memory_order_acquire)) {
+		PLATFORMFOLDERS_STAT_ADD(folderCacheHits);
+		return pf;
+	}
+	PLATFORMFOLDERS_STAT_ADD(folderCacheMisses);
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	pf = cache.instance.load(std::memory_order_relaxed);
+	if (!pf) {
+		pf = new PlatformFolders();
+		cache.instance.store(pf, std::memory_order_release);
+	}
+	else if (cache.stale.load(std::memory_order_relaxed)) {
+		pf->refresh(ec);
+		if (ec) {
+			// Still stale
+			return nullptr;
+		}
+	}
+	cache.stale.store(false, std::memory_order_release);
+	return pf;
+}
+
+const PlatformFolders& cachedPlatformFolders() {
+	std::error_code ec;
+	const PlatformFolders* pf = cachedPlatformFolders(ec);
+	if (!pf) {
+		throwResolveError(ec);
+	}
+	return *pf;
+}
+
+}  // namespace
+
+void invalidateFolderCache() {
+	invalidateEnvironment();
+#ifndef _WIN32
+	invalidatePasswdHome();
+#endif
+	FolderCache& cache = folderCache();
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	cache.stale.store(true, std::memory_order_release);
+	cache.generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+namespace internal {
+void warmFolderCache(std::error_code& ec) noexcept {
+	noThrow(ec, [&ec]() {
+		const PlatformFolders* pf = cachedPlatformFolders(ec);
+		// Resolved outside the cache lock like the other getters
+		if (pf) {
+			pf->data->snapshot(ec);
+		}
+	});
+}
+
+void throwFolderLookupError(Folder folder, const std::error_code& ec) {
+	// Throws the same exception as getFolder()
+	cachedPlatformFolders().getFolder(folder);
+	throwResolveError(ec);
+}
+
+void refreshFolderCache() {
+	invalidateFolderCache();
+	cachedPlatformFolders();
+}
+}
+
+unsigned long long getFolderCacheGeneration() {
+	return folderCache().generation.load(std::memory_order_acquire);
+}
+
+std::string getFolder(Folder folder, std::error_code& ec) noexcept {
+	ec.clear();
+	return noThrow(ec, [folder, &ec]() -> std::string {
+		const PlatformFolders* pf = cachedPlatformFolders(ec);
+		return pf ? pf->getFolder(folder, ec) : std::string();
+	});
+}
+
+std::string getFolder(Folder folder) {
+	return cachedPlatformFolders().getFolder(folder);
+}
+
+std::string getBaseDir(BaseDir dir, std::error_code& ec) noexcept {
+	switch (dir) {
+	case BaseDir::Data:
+		return getDataHome(ec);
+	case BaseDir::Config:
+		return getConfigHome(ec);
+	case BaseDir::Cache:
+		return getCacheDir(ec);
+	case BaseDir::State:
+		return getStateDir(ec);
+	}
+	ec = std::make_error_code(std::errc::invalid_argument);
+	return std::string();
+}
+
+std::string getBaseDir(BaseDir dir) {
+	std::error_code ec;
+	std::string folder = getBaseDir(dir, ec);
+	if (ec) {
+		if (ec == std::errc::invalid_argument && static_cast<std::size_t>(dir) > static_cast<std::size_t>(BaseDir::State)) {
+			throw std::invalid_argument("Unknown BaseDir");
+		}
+		throwBaseDirError(dir, ec);
+	}
+	return folder;
+}
+
+std::size_t getFolder(Folder folder, char* buffer, std::size_t bufferSize, std::error_code& ec) noexcept {
+	ec.clear();
+	PathBuffer path(buffer, bufferSize);
+	const PlatformFolders* pf = noThrow(ec, [&ec]() {
+		return cachedPlatformFolders(ec);
+	});
+	if (!pf) {
+		return 0;
+	}
+	std::shared_ptr<const FolderSnapshot> snapshot = noThrow(ec, [pf, &ec]() {
+		return pf->data->snapshot(ec);
+	});
+	if (!snapshot) {
+		return 0;
+	}
+	// Copied straight out of the snapshot. Copying the std::string first would allocate.
+	std::size_t index = folderIndex(folder);
+	if (snapshot->errorCodes[index]) {
+		ec = snapshot->errorCodes[index];
+		return 0;
+	}
+	path.append(snapshot->folders[index].data(), snapshot->folders[index].size());
+	return path.finish(ec);
+}
+
+std::string getDesktopFolder(std::error_code& ec) noexcept {
+	return getFolder(Folder::Desktop, ec);
+}
+
+std::string getDocumentsFolder(std::error_code& ec) noexcept {
+	return getFolder(Folder::Documents, ec);
+}
+
+std::string getDownloadFolder(std::error_code& ec) noexcept {
+	return getFolder(Folder::Download, ec);
+}
+
+std::string getDownloadFolder1(std::error_code& ec) noexcept {
+	return getFolder(Folder::Download, ec);
+}
+
+std::string getPicturesFolder(std::error_code& ec) noexcept {
+	return getFolder(Folder::Pictures, ec);
+}
+
+std::string getPublicFolder(std::error_code& ec) noexcept {
+	return getFolder(Folder::Public, ec);
+}
+
+std::string getMusicFolder(std::error_code& ec) noexcept {
+	return getFolder(Folder::Music, ec);
+}
+
+std::string getVideoFolder(std::error_code& ec) noexcept {
+	return getFolder(Folder::Videos, ec);
+}
+
+std::string getSaveGamesFolder1(std::error_code& ec) noexcept {
+	ec.clear();
+	const PlatformFolders* pf = noThrow(ec, [&ec]() {
+		return cachedPlatformFolders(ec);
+	});
+	return pf ? pf->getSaveGamesFolder1(ec) : std::string();
+}
+
+std::string getSaveGamesFolder2(std::error_code& ec) noexcept {
+#ifdef _WIN32
+	ec.clear();
+	return noThrow(ec, [&ec]() {
+		return GetKnownWindowsFolder(FOLDERID_SavedGames, ec);
+	});
 #else
-	return getDataHome();
+	return getSaveGamesFolder1(ec);
 #endif
 }
 
 std::string getDesktopFolder() {
-	return PlatformFolders().getDesktopFolder();
+	return cachedPlatformFolders().getDesktopFolder();
 }
 
 std::string getDocumentsFolder() {
-	return PlatformFolders().getDocumentsFolder();
+	return cachedPlatformFolders().getDocumentsFolder();
 }
 
 std::string getDownloadFolder() {
-	return PlatformFolders().getDownloadFolder1();
+	return cachedPlatformFolders().getDownloadFolder1();
 }
 
 std::string getDownloadFolder1() {
@@ -439,30 +1992,144 @@ std::string getDownloadFolder1() {
 }
 
 std::string getPicturesFolder() {
-	return PlatformFolders().getPicturesFolder();
+	return cachedPlatformFolders().getPicturesFolder();
 }
 
 std::string getPublicFolder() {
-	return PlatformFolders().getPublicFolder();
+	return cachedPlatformFolders().getPublicFolder();
 }
 
 std::string getMusicFolder() {
-	return PlatformFolders().getMusicFolder();
+	return cachedPlatformFolders().getMusicFolder();
 }
 
 std::string getVideoFolder() {
-	return PlatformFolders().getVideoFolder();
+	return cachedPlatformFolders().getVideoFolder();
 }
 
 std::string getSaveGamesFolder1() {
-	return PlatformFolders().getSaveGamesFolder1();
+	return cachedPlatformFolders().getSaveGamesFolder1();
+}
+
+#ifdef _WIN32
+static bool PlatformFoldersGetAll(AllFolders& folders, FolderSnapshot& snapshot, std::error_code& ec) {
+	folders.dataHome = GetAppData(ec);
+	if (ec) {
+		return false;
+	}
+	folders.configHome = folders.dataHome;
+	folders.cacheDir = GetAppDataLocal(ec);
+	if (ec) {
+		return false;
+	}
+	folders.stateDir = folders.cacheDir;
+	PlatformFoldersFillData(snapshot, ec);
+	for (std::size_t i = 0; i < folderCount; ++i) {
+		if (snapshot.errorCodes[i]) {
+			ec = snapshot.errorCodes[i];
+			return false;
+		}
+	}
+	folders.saveGamesFolder1 = snapshot.folders[folderIndex(Folder::Documents)]+"\\My Games";
+	folders.saveGamesFolder2 = GetKnownWindowsFolder(FOLDERID_SavedGames, ec);
+	if (ec) {
+		return false;
+	}
+	std::string common = GetAppDataCommon(ec);
+	if (ec) {
+		return false;
+	}
+	folders.additionalDataDirectories.assign(1, common);
+	folders.additionalConfigDirectories.assign(1, common);
+	return true;
+}
+#elif defined(__APPLE__)
+static bool PlatformFoldersGetAll(AllFolders& folders, FolderSnapshot& snapshot, std::error_code& ec) {
+	const std::string home = sago::internal::getHome(ec);
+	if (ec) {
+		return false;
+	}
+	folders.dataHome = home+"/Library/Application Support";
+	folders.configHome = folders.dataHome;
+	folders.cacheDir = home+"/Library/Caches";
+	folders.stateDir = folders.dataHome;
+	PlatformFoldersFillData(snapshot, home);
+	folders.saveGamesFolder1 = folders.dataHome;
+	folders.saveGamesFolder2 = folders.dataHome;
+	folders.additionalDataDirectories.clear();
+	folders.additionalConfigDirectories.clear();
+	return true;
+}
+#else
+static bool PlatformFoldersGetAll(AllFolders& folders, FolderSnapshot& snapshot, std::error_code& ec) {
+	std::shared_ptr<const Environment> environment = getEnvironment();
+	const Environment& env = *environment;
+	const uid_t uid = env.getUid();
+	// Same rule as sago::internal::getHome()
+	const char* homeEnv = env.get(Environment::Home);
+	std::string home;
+	if (uid != 0 && homeEnv) {
+		home = homeEnv;
+	}
+	else {
+		std::shared_ptr<const PasswdHome> passwdHome = cachedPasswdHome(uid, ec);
+		if (!passwdHome) {
+			return false;
+		}
+		home = passwdHome->home;
+	}
+	folders.dataHome = getLinuxFolderDefault(env, Environment::XdgDataHome, ".local/share", home, ec);
+	folders.configHome = getLinuxFolderDefault(env, Environment::XdgConfigHome, ".config", home, ec);
+	folders.cacheDir = getLinuxFolderDefault(env, Environment::XdgCacheHome, ".cache", home, ec);
+	folders.stateDir = getLinuxFolderDefault(env, Environment::XdgStateHome, ".local/state", home, ec);
+	if (ec) {
+		return false;
+	}
+	PlatformFoldersFillData(snapshot, home, folders.configHome);
+	folders.saveGamesFolder1 = folders.dataHome;
+	folders.saveGamesFolder2 = folders.dataHome;
+	folders.additionalDataDirectories.clear();
+	appendExtraFolders(env, Environment::XdgDataDirs, "/usr/local/share/:/usr/share/", folders.additionalDataDirectories, FolderListDefault);
+	folders.additionalConfigDirectories.clear();
+	appendExtraFolders(env, Environment::XdgConfigDirs, "/etc/xdg", folders.additionalConfigDirectories, FolderListDefault);
+	return true;
+}
+#endif
+
+void getAllFolders(AllFolders& folders, std::error_code& ec) noexcept {
+	ec.clear();
+	noThrow(ec, [&folders, &ec]() {
+		PLATFORMFOLDERS_STAT_ADD(lookups);
+		FolderSnapshot snapshot;
+		if (!PlatformFoldersGetAll(folders, snapshot, ec)) {
+			return;
+		}
+		for (std::size_t i = 0; i < folderCount; ++i) {
+			folders.folders[i].swap(snapshot.folders[i]);
+		}
+	});
+}
+
+void getAllFolders(AllFolders& folders) {
+	std::error_code ec;
+	getAllFolders(folders, ec);
+	if (ec) {
+#ifdef _WIN32
+		throwError(ec, "Failed to find a folder");
+#elif defined(__APPLE__)
+		throwResolveError(ec);
+#else
+		// The first of the base folders that is relative is the one that failed
+		throwLinuxFolderError(ec, Environment::XdgDataHome, Environment::XdgStateHome);
+#endif
+	}
 }
 
 std::string getSaveGamesFolder2() {
 #ifdef _WIN32
 	return GetKnownWindowsFolder(FOLDERID_SavedGames, "Failed to find Saved Games folder");
 #else
-	return PlatformFolders().getSaveGamesFolder1();
+	return cachedPlatformFolders().getSaveGamesFolder1();
 #endif
 }
 
@@ -29,25 +29,197 @@ SOFTWARE.
 #ifndef SAGO_PLATFORM_FOLDERS_H
 #define SAGO_PLATFORM_FOLDERS_H
 
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <vector>
 #include <string>
+#include <system_error>
 
 /**
  * The namespace I use for common function. Nothing special about it.
  */
 namespace sago {
 
+/**
+ * The well known user folders.
+ * On Linux these are the entries from user-dirs.dirs.
+ */
+enum class Folder {
+	Desktop,
+	Documents,
+	Download,
+	Music,
+	Pictures,
+	Public,
+	Templates,
+	Videos
+};
+
+/**
+ * The base folders. See getDataHome(), getConfigHome(), getCacheDir() and getStateDir().
+ */
+enum class BaseDir {
+	Data,
+	Config,
+	Cache,
+	State
+};
+
+/**
+ * Options for appendAdditionalDataDirectories() and appendAdditionalConfigDirectories().
+ * Combine them with |
+ */
+enum FolderListOption {
+	FolderListDefault = 0,
+	/// Remove trailing slashes so "/usr/share/" becomes "/usr/share"
+	FolderListNormalizeTrailingSlash = 1,
+	/// Skip folders that are already in the list, including those that were in it before the call
+	FolderListRemoveDuplicates = 2
+};
+
+/**
+ * The parts of the environment that the folders are resolved from: HOME, the XDG variables and the uid.
+ * All values are stored in one buffer. The environment is captured once and all lookups read from the copy.
+ * A custom EnvironmentProvider can fill one of these to resolve folders without touching the real environment.
+ * Windows does not use it.
+ */
+class Environment {
+public:
+	enum Variable {
+		Home,
+		XdgDataHome,
+		XdgConfigHome,
+		XdgCacheHome,
+		XdgStateHome,
+		XdgDataDirs,
+		XdgConfigDirs,
+		VariableCount
+	};
+	/**
+	 * An empty environment with uid 0.
+	 */
+	Environment();
+	/**
+	 * Captures the process environment with a single pass over environ.
+	 */
+	static Environment fromProcess();
+	/**
+	 * @return The name of the environment variable, like "XDG_DATA_HOME"
+	 */
+	static const char* name(Variable variable);
+	/**
+	 * @return The value or nullptr if the variable is not set. Valid until this object is modified.
+	 */
+	const char* get(Variable variable) const;
+	void set(Variable variable, const std::string& value);
+	void unset(Variable variable);
+	unsigned long getUid() const {
+		return uid;
+	}
+	void setUid(unsigned long uid) {
+		this->uid = uid;
+	}
+private:
+	static const std::size_t unsetOffset = static_cast<std::size_t>(-1);
+	// Null terminated values
+	std::string buffer;
+	std::size_t offsets[VariableCount];
+	unsigned long uid;
+};
+
+/**
+ * Returns the environment that the folders are resolved from.
+ */
+typedef std::function<Environment()> EnvironmentProvider;
+
+/**
+ * Problems in the configuration that are skipped instead of causing an error.
+ */
+enum class Diagnostic {
+	/// An entry in XDG_DATA_DIRS or XDG_CONFIG_DIRS was not an absolute path
+	RelativePathInList,
+	/// A line in user-dirs.dirs could not be parsed
+	InvalidUserDirsLine
+};
+
+/**
+ * A histogram of how long something took.
+ * Bucket 0 counts calls that took less than 1 microsecond. Bucket i counts calls that took
+ * at least 2^(i-1) and less than 2^i microseconds. The last bucket also counts everything slower.
+ */
+struct LatencyHistogram {
+	static const std::size_t bucketCount = 20;
+	unsigned long long buckets[bucketCount];
+	unsigned long long count;
+	unsigned long long totalNanoseconds;
+};
+
+/**
+ * Counters filled by getStats(). Only collected if the library was built with PLATFORMFOLDERS_ENABLE_STATS.
+ */
+struct Stats {
+	/// Folder lookups through the free functions and getAllFolders()
+	unsigned long long lookups;
+	/// Lookups answered by the process-wide folder cache
+	unsigned long long folderCacheHits;
+	/// Lookups that had to fill or refresh the process-wide folder cache
+	unsigned long long folderCacheMisses;
+	/// Attempts to read user-dirs.dirs, including when it does not exist
+	unsigned long long userDirsReads;
+	/// Calls to getpwuid_r()
+	unsigned long long passwdLookups;
+	/// Home lookups answered by the cached passwd entry
+	unsigned long long passwdCacheHits;
+	/// Diagnostics reported. Same as getDiagnosticCount()
+	unsigned long long warnings;
+	/// XDG variables rejected because they were not absolute paths
+	unsigned long long relativePathErrors;
+	/// Time spent resolving the folders of a PlatformFolders object
+	LatencyHistogram resolve;
+	/// Time spent in sago::internal::getHome()
+	LatencyHistogram getHome;
+};
+
+/**
+ * Receives diagnostics. The message is only valid during the call.
+ * It may be called from several threads at the same time.
+ */
+typedef std::function<void(Diagnostic kind, const char* message)> DiagnosticSink;
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 namespace internal {
+// The number of values in Folder
+const std::size_t folderCount = static_cast<std::size_t>(Folder::Videos) + 1;
 #if !defined(_WIN32) && !defined(__APPLE__)
-void appendExtraFoldersTokenizer(const char* envName, const char* envValue, std::vector<std::string>& folders);
+void appendExtraFoldersTokenizer(const char* envName, const char* envValue, std::vector<std::string>& folders, int options = FolderListDefault);
+// Called for every XDG_*_DIR entry. The value has been unquoted. If relativeToHome is true the value followed a leading $HOME.
+typedef std::function<void(const char* key, std::size_t keyLength, std::string& value, bool relativeToHome)> UserDirsCallback;
+void parseUserDirs(const char* filename, const char* data, std::size_t size, const UserDirsCallback& onEntry);
+void parseUserDirsFile(const std::string& filename, const UserDirsCallback& onEntry);
+// Same as above but reads from a descriptor the caller has opened and closes. filename is only used in warnings.
+void parseUserDirsFile(const std::string& filename, int fd, const UserDirsCallback& onEntry);
 #endif
 #ifdef _WIN32
 std::string win32_utf16_to_utf8(const wchar_t* wstr);
 #endif
 #ifndef _WIN32
 std::string getHome();
+// Same as getHome() but reports errors through ec
+std::string getHome(std::error_code& ec) noexcept;
+// Looks up the home directory of any uid with the passwd provider. Not cached.
+bool lookupHome(unsigned long uid, std::string& home, std::error_code& ec) noexcept;
+// Looks up the uid of a login name with the user name provider. Not cached.
+bool lookupUid(const std::string& userName, unsigned long& uid, std::error_code& ec) noexcept;
+#endif
+// Invalidates the process-wide cache and fills it again right away
+void refreshFolderCache();
+// Sends a printf style message to the diagnostic sink
+void reportDiagnostic(Diagnostic kind, const char* format, ...)
+#ifdef __GNUC__
+	__attribute__((format(printf, 2, 3)))
 #endif
+	;
 }
 #endif  //DOXYGEN_SHOULD_SKIP_THIS
 
@@ -101,6 +273,51 @@ std::string getCacheDir();
  */
 std::string getStateDir();
 
+/**
+ * Allocation free versions of getDataHome(), getConfigHome(), getCacheDir() and getStateDir().
+ * The path and a terminating null character is written to buffer.
+ * @code{.cpp}
+ * char path[PATH_MAX];
+ * std::error_code ec;
+ * sago::getDataHome(path, sizeof(path), ec);
+ * if (!ec) {
+ *     // use path
+ * }
+ * @endcode
+ * If the path does not fit, ec is set to std::errc::result_out_of_range, the buffer holds an empty string and the required length is returned.
+ * If the folder could not be found, ec is set and 0 is returned. A relative XDG variable gives std::errc::invalid_argument.
+ * @note Windows: The shell allocates internally when looking up the folder.
+ * @param buffer Where to write the path
+ * @param bufferSize The size of buffer in bytes
+ * @param ec Set if the path could not be written
+ * @return The length of the path excluding the terminating null character
+ */
+std::size_t getDataHome(char* buffer, std::size_t bufferSize, std::error_code& ec) noexcept;
+std::size_t getConfigHome(char* buffer, std::size_t bufferSize, std::error_code& ec) noexcept;
+std::size_t getCacheDir(char* buffer, std::size_t bufferSize, std::error_code& ec) noexcept;
+std::size_t getStateDir(char* buffer, std::size_t bufferSize, std::error_code& ec) noexcept;
+
+/**
+ * Exception free versions of getDataHome(), getConfigHome(), getCacheDir() and getStateDir().
+ * The throwing versions are thin wrappers around these. Nothing in the failure path throws.
+ * @code{.cpp}
+ * std::error_code ec;
+ * std::string dataHome = sago::getDataHome(ec);
+ * if (ec) {
+ *     // handle the error
+ * }
+ * @endcode
+ * The error codes are the same as for the buffer versions. A relative XDG variable gives std::errc::invalid_argument.
+ * A failed passwd lookup gives the error from getpwuid_r() or std::errc::no_such_file_or_directory if there is no entry.
+ * A failed allocation gives std::errc::not_enough_memory. On Windows the HRESULT is reported in std::system_category().
+ * @param ec Set if the folder could not be found, cleared otherwise
+ * @return Absolute path to the folder or an empty string on failure
+ */
+std::string getDataHome(std::error_code& ec) noexcept;
+std::string getConfigHome(std::error_code& ec) noexcept;
+std::string getCacheDir(std::error_code& ec) noexcept;
+std::string getStateDir(std::error_code& ec) noexcept;
+
 /**
  * This will append extra folders that your program should be looking for data files in.
  * This does not normally include the path returned by GetDataHome().
@@ -119,6 +336,17 @@ std::string getStateDir();
  */
 void appendAdditionalDataDirectories(std::vector<std::string>& homes);
 
+/**
+ * Same as appendAdditionalDataDirectories(homes) but with options.
+ * Environments like Nix and Flatpak often repeat the same folder many times in XDG_DATA_DIRS.
+ * @code{.cpp}
+ * sago::appendAdditionalDataDirectories(folders, sago::FolderListNormalizeTrailingSlash | sago::FolderListRemoveDuplicates);
+ * @endcode
+ * @param homes A vector that extra folders will be appended to.
+ * @param options A combination of FolderListOption values
+ */
+void appendAdditionalDataDirectories(std::vector<std::string>& homes, int options);
+
 /**
  * This will append extra folders that your program should be looking for config files in.
  * This does not normally include the path returned by GetConfigHome().
@@ -137,6 +365,22 @@ void appendAdditionalDataDirectories(std::vector<std::string>& homes);
  */
 void appendAdditionalConfigDirectories(std::vector<std::string>& homes);
 
+/**
+ * Same as appendAdditionalConfigDirectories(homes) but with options.
+ * @param homes A vector that extra folders will be appended to.
+ * @param options A combination of FolderListOption values
+ */
+void appendAdditionalConfigDirectories(std::vector<std::string>& homes, int options);
+
+/**
+ * Exception free versions of appendAdditionalDataDirectories() and appendAdditionalConfigDirectories().
+ * @param homes A vector that extra folders will be appended to. Nothing is appended if ec is set.
+ * @param options A combination of FolderListOption values
+ * @param ec Set if the folders could not be found, cleared otherwise
+ */
+void appendAdditionalDataDirectories(std::vector<std::string>& homes, int options, std::error_code& ec) noexcept;
+void appendAdditionalConfigDirectories(std::vector<std::string>& homes, int options, std::error_code& ec) noexcept;
+
 /**
  * The folder that represents the desktop.
  * Normally you should try not to use this folder.
@@ -213,6 +457,283 @@ std::string getSaveGamesFolder1();
  */
 std::string getSaveGamesFolder2();
 
+/**
+ * Exception free versions of the user folder getters. They work like getDataHome(std::error_code&).
+ * @param ec Set if the folder could not be found, cleared otherwise
+ * @return Absolute path to the folder or an empty string on failure
+ */
+std::string getDesktopFolder(std::error_code& ec) noexcept;
+std::string getDocumentsFolder(std::error_code& ec) noexcept;
+std::string getDownloadFolder(std::error_code& ec) noexcept;
+std::string getDownloadFolder1(std::error_code& ec) noexcept;
+std::string getPicturesFolder(std::error_code& ec) noexcept;
+std::string getPublicFolder(std::error_code& ec) noexcept;
+std::string getMusicFolder(std::error_code& ec) noexcept;
+std::string getVideoFolder(std::error_code& ec) noexcept;
+std::string getSaveGamesFolder1(std::error_code& ec) noexcept;
+std::string getSaveGamesFolder2(std::error_code& ec) noexcept;
+
+/**
+ * Every folder the library knows about. Filled by getAllFolders().
+ */
+struct AllFolders {
+	std::string dataHome;
+	std::string configHome;
+	std::string cacheDir;
+	std::string stateDir;
+	std::string saveGamesFolder1;
+	std::string saveGamesFolder2;
+	/// The user folders indexed by Folder. Use folder() to read them.
+	std::string folders[internal::folderCount];
+	std::vector<std::string> additionalDataDirectories;
+	std::vector<std::string> additionalConfigDirectories;
+
+	const std::string& folder(Folder f) const {
+		return folders[static_cast<std::size_t>(f)];
+	}
+};
+
+/**
+ * Resolves all folders in one go.
+ * This is cheaper than calling all the getters one by one. The home folder is looked up once,
+ * the environment is scanned once and user-dirs.dirs is read once.
+ * The result does not depend on the process-wide cache used by the free functions.
+ * @code{.cpp}
+ * sago::AllFolders folders;
+ * sago::getAllFolders(folders);
+ * std::cout << folders.configHome << " " << folders.folder(sago::Folder::Documents) << "\n";
+ * @endcode
+ * @param folders The struct to fill. Existing values are replaced.
+ */
+void getAllFolders(AllFolders& folders);
+
+/**
+ * Exception free version of getAllFolders(AllFolders&).
+ * @param folders The struct to fill. Its contents are unspecified if ec is set.
+ * @param ec Set if a folder could not be found, cleared otherwise
+ */
+void getAllFolders(AllFolders& folders, std::error_code& ec) noexcept;
+
+/**
+ * One of the well known user folders by enum.
+ * @param folder The folder to look up
+ * @return Absolute path to the folder
+ */
+std::string getFolder(Folder folder);
+
+/**
+ * Exception free version of getFolder(Folder).
+ * @param folder The folder to look up
+ * @param ec Set if the folder could not be found, cleared otherwise
+ * @return Absolute path to the folder or an empty string on failure
+ */
+std::string getFolder(Folder folder, std::error_code& ec) noexcept;
+
+/**
+ * One of the base folders by enum. Same as calling getDataHome(), getConfigHome(), getCacheDir() or getStateDir().
+ * @param dir The folder to look up
+ * @return Absolute path to the folder
+ */
+std::string getBaseDir(BaseDir dir);
+
+/**
+ * Exception free version of getBaseDir(BaseDir). An unknown dir gives std::errc::invalid_argument.
+ * @param dir The folder to look up
+ * @param ec Set if the folder could not be found, cleared otherwise
+ * @return Absolute path to the folder or an empty string on failure
+ */
+std::string getBaseDir(BaseDir dir, std::error_code& ec) noexcept;
+
+/**
+ * Allocation free lookup of one of the well known user folders.
+ * The folders are taken from the process-wide cache. Only the first call, that fills the cache, allocates.
+ * The buffer and return value work the same way as the buffer version of getDataHome().
+ * @param folder The folder to look up
+ * @param buffer Where to write the path
+ * @param bufferSize The size of buffer in bytes
+ * @param ec Set if the path could not be written
+ * @return The length of the path excluding the terminating null character
+ */
+std::size_t getFolder(Folder folder, char* buffer, std::size_t bufferSize, std::error_code& ec) noexcept;
+
+/**
+ * What is known about a Folder at compile time.
+ */
+struct FolderInfo {
+	/// The key in user-dirs.dirs, like "XDG_MUSIC_DIR". Only used on Linux.
+	const char* xdgKey;
+	/// Appended to the home folder if user-dirs.dirs does not name the folder. Not used on Windows.
+	const char* homeRelative;
+};
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace internal {
+// Indexed by Folder
+constexpr FolderInfo folderTable[folderCount] = {
+	{ "XDG_DESKTOP_DIR", "/Desktop" },
+	{ "XDG_DOCUMENTS_DIR", "/Documents" },
+	{ "XDG_DOWNLOAD_DIR", "/Downloads" },
+	{ "XDG_MUSIC_DIR", "/Music" },
+	{ "XDG_PICTURES_DIR", "/Pictures" },
+	{ "XDG_PUBLICSHARE_DIR", "/Public" },
+#ifdef __APPLE__
+	{ "XDG_TEMPLATES_DIR", "/Templates" },
+	{ "XDG_VIDEOS_DIR", "/Movies" },
+#else
+	{ "XDG_TEMPLATES_DIR", "/.Templates" },
+	{ "XDG_VIDEOS_DIR", "/Videos" },
+#endif
+};
+// Resolves the folders of the process-wide cache if needed. Used by startFolderWarmup().
+void warmFolderCache(std::error_code& ec) noexcept;
+[[noreturn]] void throwFolderLookupError(Folder folder, const std::error_code& ec);
+}
+#endif
+
+/**
+ * @param folder The folder to describe
+ * @return The compile time description of the folder
+ */
+constexpr FolderInfo getFolderInfo(Folder folder) {
+	return internal::folderTable[static_cast<std::size_t>(folder)];
+}
+
+/**
+ * One of the well known user folders, selected at compile time.
+ * Reads the folder from the process-wide cache. An unknown folder does not compile.
+ * The folder is copied, so the result stays valid when another thread invalidates the cache.
+ * Use the buffer version of getFolder() to avoid the allocation.
+ * @code{.cpp}
+ * std::string music = sago::get<sago::Folder::Music>();
+ * @endcode
+ * @param ec Set if the folder could not be found, cleared otherwise
+ * @return Absolute path to the folder or an empty string on failure
+ */
+template <Folder F>
+inline std::string get(std::error_code& ec) noexcept {
+	static_assert(static_cast<std::size_t>(F) < internal::folderCount, "Unknown folder");
+	return getFolder(F, ec);
+}
+
+/**
+ * Same as get(std::error_code&) but throws if the folder could not be found.
+ * @return Absolute path to the folder
+ */
+template <Folder F>
+inline std::string get() {
+	std::error_code ec;
+	std::string folder = get<F>(ec);
+	if (ec) {
+		internal::throwFolderLookupError(F, ec);
+	}
+	return folder;
+}
+
+/**
+ * The free functions above share a process-wide cache of the resolved folders.
+ * The cache is filled on first use and kept until it is invalidated.
+ * Call this if user-dirs.dirs or the environment has changed and the folders must be resolved again.
+ * This also drops the cached home directory from the passwd database.
+ * It is safe to call this while other threads are reading folders.
+ */
+void invalidateFolderCache();
+
+/**
+ * Returns the generation of the process-wide folder cache.
+ * The value is increased every time invalidateFolderCache() is called.
+ * This can be used to detect that previously fetched paths might be stale.
+ * @return The current cache generation.
+ */
+unsigned long long getFolderCacheGeneration();
+
+/**
+ * Replaces where the environment is read from. By default it is Environment::fromProcess().
+ * Mostly useful for tests and benchmarks that must not depend on or modify the real environment.
+ * This invalidates the process-wide cache.
+ * @param provider The new provider. An empty function restores the default.
+ */
+void setEnvironmentProvider(EnvironmentProvider provider);
+
+/**
+ * The environment used by all lookups. It is captured from the provider on first use and again
+ * after invalidateFolderCache(). Changes to the process environment after that are not seen until
+ * invalidateFolderCache() is called. The exception is the uid: the process environment is captured
+ * again when getuid() has changed, so getHome() looks up the new user after setuid().
+ * @return The current environment. It stays valid for as long as it is held, even if a newer one is captured meanwhile.
+ */
+std::shared_ptr<const Environment> getEnvironment();
+
+#ifndef _WIN32
+/**
+ * Looks up the home folder of a uid. Must return false and set ec if there is none.
+ */
+typedef std::function<bool(unsigned long uid, std::string& home, std::error_code& ec)> PasswdProvider;
+
+/**
+ * Replaces how the home folder is looked up when HOME is not used. By default getpwuid_r() is called.
+ * Mostly useful for tests that need a slow or failing name service.
+ * The provider is called with an internal lock held, so concurrent lookups wait for it instead of calling it again.
+ * This invalidates the process-wide cache.
+ * @param provider The new provider. An empty function restores the default.
+ * @note Not available on Windows
+ */
+void setPasswdProvider(PasswdProvider provider);
+
+/**
+ * Looks up the uid of a login name. Must return false and set ec if there is no such user.
+ */
+typedef std::function<bool(const std::string& userName, unsigned long& uid, std::error_code& ec)> UserNameProvider;
+
+/**
+ * Replaces how UserFolders finds the uid of a user name. By default getpwnam_r() is called.
+ * Together with setPasswdProvider() this lets tests use users that do not exist on the machine.
+ * This invalidates the process-wide cache.
+ * @param provider The new provider. An empty function restores the default.
+ * @note Not available on Windows
+ */
+void setUserNameProvider(UserNameProvider provider);
+#endif
+
+/**
+ * Replaces where diagnostics are sent.
+ * By default they are written to std::cerr, but every distinct message is only written once
+ * and after 64 distinct messages the rest are dropped.
+ * A custom sink receives every diagnostic.
+ * @code{.cpp}
+ * // Never write anything. Diagnostics are still counted by getDiagnosticCount().
+ * sago::setDiagnosticSink(sago::DiagnosticSink());
+ * @endcode
+ * @param sink The new sink. An empty function silences diagnostics and skips formatting the message.
+ */
+void setDiagnosticSink(DiagnosticSink sink);
+
+/**
+ * Restores the default deduplicating std::cerr sink.
+ */
+void resetDiagnosticSink();
+
+/**
+ * @return The number of diagnostics reported so far, including silenced and deduplicated ones.
+ */
+unsigned long long getDiagnosticCount();
+
+/**
+ * @return true if the library was built with PLATFORMFOLDERS_ENABLE_STATS.
+ * Without it the counters cost nothing and getStats() always reports zero.
+ */
+bool statsEnabled();
+
+/**
+ * Copies the current counters. Each counter is read atomically but they are not read as one snapshot.
+ * @param stats Where to write the counters
+ */
+void getStats(Stats& stats);
+
+/**
+ * Sets all counters to zero.
+ */
+void resetStats();
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
 /**
@@ -220,11 +741,42 @@ std::string getSaveGamesFolder2();
  * For Windows these folders are either by convention or given by CSIDL.
  * For Linux XDG convention is used.
  * The Linux version has very little error checking and assumes that the config is correct
+ * All const methods may be called concurrently from several threads, also while refresh() is running.
+ * The folders are resolved on the first call to a getter that needs them, not in the constructor.
+ * If resolving fails the getter throws and the next call tries again.
  */
 class PlatformFolders {
 public:
+	/**
+	 * Cheap. Does not look up home or read any files.
+	 */
 	PlatformFolders();
 	~PlatformFolders();
+	/**
+	 * Resolves the folders again and atomically replaces the ones returned by the getters.
+	 * Threads reading at the same time see either the old or the new values, never a mix.
+	 * Unlike the getters this resolves the folders right away.
+	 */
+	void refresh();
+	/**
+	 * Exception free version of refresh(). The old folders are kept if ec is set.
+	 * @param ec Set if the folders could not be resolved, cleared otherwise
+	 */
+	void refresh(std::error_code& ec) noexcept;
+	/**
+	 * Looks up one of the well known folders.
+	 * The folder is copied out of the current snapshot, so a concurrent refresh() cannot change or free it.
+	 * @param folder The folder to look up
+	 * @return Absolute path to the folder
+	 */
+	std::string getFolder(Folder folder) const;
+	/**
+	 * Exception free version of getFolder(Folder).
+	 * @param folder The folder to look up
+	 * @param ec Set if the folder could not be found, cleared otherwise
+	 * @return Absolute path to the folder or an empty string on failure
+	 */
+	std::string getFolder(Folder folder, std::error_code& ec) const noexcept;
 	/**
 	 * The folder that represents the desktop.
 	 * Normally you should try not to use this folder.
@@ -270,16 +822,23 @@ public:
 	 * @endcode
 	 * @note Windows: This is an XP compatible version and returns the path to "My Games" in Documents. Vista and later has an official folder.
 	 * @note Linux: XDF does not define a folder for saved games. This will just return the same as GetDataHome()
+	 * @note Only Windows needs the other folders to be resolved for this.
 	 * @return The folder base folder for storing save games.
 	 */
 	std::string getSaveGamesFolder1() const;
+	/**
+	 * Exception free version of getSaveGamesFolder1().
+	 * @param ec Set if the folder could not be found, cleared otherwise
+	 * @return The folder or an empty string on failure
+	 */
+	std::string getSaveGamesFolder1(std::error_code& ec) const noexcept;
 private:
 	PlatformFolders(const PlatformFolders&) = delete;
 	PlatformFolders& operator=(const PlatformFolders&) = delete;
-#if !defined(_WIN32) && !defined(__APPLE__)
+	friend void internal::warmFolderCache(std::error_code& ec) noexcept;
+	friend std::size_t getFolder(Folder folder, char* buffer, std::size_t bufferSize, std::error_code& ec) noexcept;
 	struct PlatformFoldersData;
 	PlatformFoldersData* data;
-#endif
 };
 
 #endif // skip doxygen
@@ -0,0 +1,315 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015-2016 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "user_dirs_watcher.h"
+
+#ifdef __linux__
+
+#include "platform_folders.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sago {
+
+namespace {
+
+const char userDirsFile[] = "user-dirs.dirs";
+// Watching the folder also catches editors that write a new file and rename it over the old one
+const std::uint32_t configHomeEvents = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF;
+// A parent is only watched until the next folder on the way to the config folder appears
+const std::uint32_t parentEvents = IN_CREATE | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+/**
+ * What we compare to decide if the file has actually changed
+ */
+struct FileSignature {
+	bool exists;
+	ino_t inode;
+	off_t size;
+	struct timespec mtime;
+};
+
+FileSignature readSignature(const std::string& path) {
+	FileSignature signature;
+	std::memset(&signature, 0, sizeof(signature));
+	struct stat st;
+	if (stat(path.c_str(), &st) == 0) {
+		signature.exists = true;
+		signature.inode = st.st_ino;
+		signature.size = st.st_size;
+		signature.mtime = st.st_mtim;
+	}
+	return signature;
+}
+
+bool operator==(const FileSignature& a, const FileSignature& b) {
+	if (a.exists != b.exists) {
+		return false;
+	}
+	if (!a.exists) {
+		return true;
+	}
+	return a.inode == b.inode && a.size == b.size && a.mtime.tv_sec == b.mtime.tv_sec && a.mtime.tv_nsec == b.mtime.tv_nsec;
+}
+
+}  // namespace
+
+struct UserDirsWatcher::UserDirsWatcherData {
+	int inotifyFd = -1;
+	// Writing to stopPipe[1] wakes up the watcher thread so it can exit
+	int stopPipe[2] = { -1, -1 };
+	std::string configHome;
+	std::string path;
+	// configHome or the closest parent of it that exists. -1 if nothing could be watched.
+	int watch = -1;
+	std::string watchedFolder;
+	// The child of watchedFolder on the way to configHome. Empty if configHome itself is watched.
+	std::string nextName;
+	FileSignature signature;
+	std::thread thread;
+	std::mutex callbackMutex;
+	std::map<std::size_t, Callback> callbacks;
+	std::size_t nextId = 0;
+
+	~UserDirsWatcherData() {
+		if (inotifyFd >= 0) {
+			close(inotifyFd);
+		}
+		if (stopPipe[0] >= 0) {
+			close(stopPipe[0]);
+			close(stopPipe[1]);
+		}
+	}
+
+	/**
+	 * Watches configHome. If it does not exist the closest existing parent is watched instead.
+	 * @return false if no folder could be watched. errno is then set.
+	 */
+	bool watchNearest() {
+		for (;;) {
+			std::string folder = configHome;
+			std::string next;
+			int newWatch = -1;
+			for (;;) {
+				newWatch = inotify_add_watch(inotifyFd, folder.c_str(), next.empty() ? configHomeEvents : parentEvents);
+				if (newWatch >= 0) {
+					break;
+				}
+				std::size_t slash = folder.rfind('/');
+				if ((errno != ENOENT && errno != ENOTDIR) || slash == std::string::npos || folder == "/") {
+					int error = errno;
+					if (watch >= 0) {
+						inotify_rm_watch(inotifyFd, watch);
+						watch = -1;
+					}
+					errno = error;
+					return false;
+				}
+				next = folder.substr(slash + 1);
+				folder = slash == 0 ? std::string("/") : folder.substr(0, slash);
+			}
+			if (watch >= 0 && watch != newWatch) {
+				// Fails harmlessly if the old folder is already gone
+				inotify_rm_watch(inotifyFd, watch);
+			}
+			watch = newWatch;
+			watchedFolder = folder;
+			nextName = next;
+			// The next folder might have been created after it was found missing but before the watch was added.
+			// There is no event for it then, so start over from the config folder.
+			struct stat st;
+			if (next.empty() || stat((folder == "/" ? folder + next : folder + "/" + next).c_str(), &st) != 0) {
+				return true;
+			}
+		}
+	}
+
+	/**
+	 * Reads all pending inotify events.
+	 * @param rearm Set to true if the watched folder changed and watchNearest() must be called
+	 * @return true if one of them could have changed user-dirs.dirs
+	 */
+	bool readEvents(bool& rearm) {
+		alignas(struct inotify_event) char buffer[4096];
+		bool relevant = false;
+		for (;;) {
+			ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+			if (length <= 0) {
+				return relevant;
+			}
+			for (char* ptr = buffer; ptr < buffer + length; ) {
+				const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+				ptr += sizeof(struct inotify_event) + event->len;
+				if (event->mask & IN_Q_OVERFLOW) {
+					relevant = true;
+					rearm = true;
+					continue;
+				}
+				if (event->wd != watch) {
+					// Left over from a folder that is no longer watched
+					continue;
+				}
+				if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+					// The watched folder is gone. Fall back to its parent.
+					relevant = true;
+					rearm = true;
+				}
+				else if (event->len > 0 && nextName.empty() && std::strcmp(event->name, userDirsFile) == 0) {
+					relevant = true;
+				}
+				else if (event->len > 0 && !nextName.empty() && nextName == event->name) {
+					// A folder on the way to the config folder appeared. The file might already be in it.
+					relevant = true;
+					rearm = true;
+				}
+			}
+		}
+	}
+
+	void notify() {
+		std::vector<Callback> toCall;
+		{
+			// Callbacks are called without holding the lock so that they may call subscribe() and unsubscribe()
+			std::lock_guard<std::mutex> lock(callbackMutex);
+			for (std::map<std::size_t, Callback>::const_iterator itr = callbacks.begin(); itr != callbacks.end(); ++itr) {
+				toCall.push_back(itr->second);
+			}
+		}
+		for (std::size_t i = 0; i < toCall.size(); ++i) {
+			toCall[i]();
+		}
+	}
+
+	void run() {
+		struct pollfd fds[2];
+		fds[0].fd = inotifyFd;
+		fds[0].events = POLLIN;
+		fds[1].fd = stopPipe[0];
+		fds[1].events = POLLIN;
+		for (;;) {
+			fds[0].revents = 0;
+			fds[1].revents = 0;
+			if (poll(fds, 2, -1) < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return;
+			}
+			if (fds[1].revents) {
+				return;
+			}
+			bool rearm = false;
+			if (!readEvents(rearm)) {
+				continue;
+			}
+			if (rearm) {
+				// On failure nothing is watched any more. Only the stop pipe can wake us up then.
+				watchNearest();
+			}
+			FileSignature current = readSignature(path);
+			if (current == signature) {
+				continue;
+			}
+			signature = current;
+			try {
+				sago::internal::refreshFolderCache();
+			}
+			catch (...) {
+				// Keep watching. The next reader will get the error from the free functions.
+				continue;
+			}
+			notify();
+		}
+	}
+};
+
+UserDirsWatcher::UserDirsWatcher() : data(new UserDirsWatcherData()) {
+	try {
+		std::string configHome = getConfigHome();
+		while (configHome.size() > 1 && configHome[configHome.size() - 1] == '/') {
+			configHome.erase(configHome.size() - 1);
+		}
+		data->configHome = configHome;
+		data->path = configHome + "/" + userDirsFile;
+		data->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (data->inotifyFd < 0) {
+			throw std::runtime_error(std::string("inotify_init1 failed: ") + std::strerror(errno));
+		}
+		if (!data->watchNearest()) {
+			throw std::runtime_error("Failed to watch \"" + configHome + "\": " + std::strerror(errno));
+		}
+		// Read after the watch is in place so a change in between is not missed
+		data->signature = readSignature(data->path);
+		if (pipe2(data->stopPipe, O_CLOEXEC) != 0) {
+			throw std::runtime_error(std::string("pipe2 failed: ") + std::strerror(errno));
+		}
+		data->thread = std::thread(&UserDirsWatcherData::run, data);
+	}
+	catch (...) {
+		delete data;
+		throw;
+	}
+}
+
+UserDirsWatcher::~UserDirsWatcher() {
+	char stop = 0;
+	ssize_t written;
+	do {
+		written = write(data->stopPipe[1], &stop, 1);
+	} while (written < 0 && errno == EINTR);
+	data->thread.join();
+	delete data;
+}
+
+std::size_t UserDirsWatcher::subscribe(Callback callback) {
+	std::lock_guard<std::mutex> lock(data->callbackMutex);
+	std::size_t id = data->nextId++;
+	data->callbacks[id] = callback;
+	return id;
+}
+
+void UserDirsWatcher::unsubscribe(std::size_t id) {
+	std::lock_guard<std::mutex> lock(data->callbackMutex);
+	data->callbacks.erase(id);
+}
+
+}  // namespace sago
+
+#endif
@@ -0,0 +1,87 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SAGO_USER_DIRS_WATCHER_H
+#define SAGO_USER_DIRS_WATCHER_H
+
+#include <cstddef>
+#include <functional>
+
+namespace sago {
+
+#ifdef __linux__
+
+/**
+ * Watches user-dirs.dirs with inotify and updates the process-wide folder cache when it changes.
+ * The watched file is getConfigHome()+"/user-dirs.dirs" at the time the watcher is constructed.
+ * A background thread sleeps until inotify reports an event in the config folder.
+ * If the config folder does not exist yet, its closest existing parent is watched until the folder is created.
+ * The file is only parsed again if its inode, size or modification time changed.
+ * After the cache has been updated the subscribed callbacks are called on the watcher thread.
+ * @code{.cpp}
+ * sago::UserDirsWatcher watcher;
+ * watcher.subscribe([]() {
+ *     std::cout << "Documents moved to " << sago::getDocumentsFolder() << "\n";
+ * });
+ * @endcode
+ * @note Only available on Linux
+ */
+class UserDirsWatcher {
+public:
+	typedef std::function<void()> Callback;
+	/**
+	 * Starts watching. Throws std::runtime_error if inotify could not be set up or no parent of the config folder can be watched.
+	 */
+	UserDirsWatcher();
+	/**
+	 * Stops the watcher thread. No callbacks are called after the destructor returns.
+	 */
+	~UserDirsWatcher();
+	/**
+	 * Registers a callback that is called every time the folders have been updated.
+	 * @param callback Called on the watcher thread
+	 * @return An id that can be passed to unsubscribe()
+	 */
+	std::size_t subscribe(Callback callback);
+	/**
+	 * Removes a callback registered with subscribe()
+	 * @param id The value returned by subscribe()
+	 */
+	void unsubscribe(std::size_t id);
+private:
+	UserDirsWatcher(const UserDirsWatcher&) = delete;
+	UserDirsWatcher& operator=(const UserDirsWatcher&) = delete;
+	struct UserDirsWatcherData;
+	UserDirsWatcherData* data;
+};
+
+#endif
+
+}  //namespace sago
+
+#endif  /* SAGO_USER_DIRS_WATCHER_H */
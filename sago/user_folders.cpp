@@ -0,0 +1,474 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015-2016 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "user_folders.h"
+
+#ifndef _WIN32
+
+#include "internal_error.h"
+#include "internal_posix.h"
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sago {
+
+namespace {
+
+using internal::folderCount;
+
+const std::size_t baseDirCount = static_cast<std::size_t>(BaseDir::State) + 1;
+
+/**
+ * What user-dirs.dirs looked like when it was read. A file that does not exist has exists set to false.
+ */
+struct UserDirsStamp {
+	bool exists;
+	dev_t device;
+	ino_t inode;
+	off_t size;
+	struct timespec mtime;
+	// A chown() or chmod() can make the file trusted or untrusted without touching the contents
+	uid_t owner;
+	mode_t mode;
+};
+
+bool operator==(const UserDirsStamp& a, const UserDirsStamp& b) {
+	if (a.exists != b.exists) {
+		return false;
+	}
+	return !a.exists || (a.device == b.device && a.inode == b.inode && a.size == b.size &&
+		a.mtime.tv_sec == b.mtime.tv_sec && a.mtime.tv_nsec == b.mtime.tv_nsec && a.owner == b.owner && a.mode == b.mode);
+}
+
+/**
+ * Stamps the file itself. A symbolic link is not followed, as it would not be read either.
+ */
+UserDirsStamp stampUserDirs(const std::string& path) {
+	UserDirsStamp stamp = UserDirsStamp();
+	struct stat st;
+	if (lstat(path.c_str(), &st) == 0) {
+		stamp.exists = true;
+		stamp.device = st.st_dev;
+		stamp.inode = st.st_ino;
+		stamp.size = st.st_size;
+		stamp.mtime = internal::modificationTime(st);
+		stamp.owner = st.st_uid;
+		stamp.mode = st.st_mode;
+	}
+	return stamp;
+}
+
+/**
+ * Opens user-dirs.dirs of uid if it can be trusted: a regular file that is not a symbolic link,
+ * owned by uid and not writable by the group or others. Anything else could point a service running
+ * as root at a file chosen by another user.
+ * @return The descriptor or -1 if the file does not exist or is not trusted
+ */
+int openTrustedUserDirs(const std::string& path, unsigned long uid) {
+	// O_NONBLOCK so a FIFO in place of the file cannot block the open
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW | O_NONBLOCK);
+	if (fd < 0) {
+		return -1;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != uid || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+}  // namespace
+
+/**
+ * The resolved folders of one user. Never modified after it has been put in the cache.
+ */
+struct UserFolders::UserFoldersData {
+	unsigned long uid;
+	std::string home;
+	std::string baseDirs[baseDirCount];
+	std::string folders[folderCount];
+	// Empty on macOS, which has no user-dirs.dirs
+	std::string userDirsPath;
+	UserDirsStamp stamp;
+
+	UserFoldersData() : uid(0), stamp() {}
+
+	/**
+	 * Process-wide LRU of resolved users keyed by uid.
+	 * Entries are handed out as shared pointers, so evicting one does not affect the objects using it.
+	 * The lock is not held while resolving. Two threads that miss on the same user both resolve it and the last one wins.
+	 */
+	struct Cache {
+		struct Entry {
+			std::shared_ptr<const UserFoldersData> data;
+			// The names this uid was looked up by
+			std::vector<std::string> names;
+		};
+		typedef std::list<Entry> EntryList;
+		std::mutex mutex;
+		std::size_t limit;
+		unsigned long long generation;
+		// Most recently used first
+		EntryList entries;
+		std::unordered_map<unsigned long, EntryList::iterator> byUid;
+		std::unordered_map<std::string, unsigned long> uidByName;
+		Cache() : limit(256), generation(getFolderCacheGeneration()) {}
+
+		// Must be called with the mutex held. Drops everything if sago::invalidateFolderCache() was called.
+		void checkGeneration() {
+			unsigned long long current = getFolderCacheGeneration();
+			if (generation != current) {
+				generation = current;
+				entries.clear();
+				byUid.clear();
+				uidByName.clear();
+			}
+		}
+
+		// Must be called with the mutex held
+		void evict() {
+			while (entries.size() > limit) {
+				Entry& last = entries.back();
+				for (const std::string& name : last.names) {
+					uidByName.erase(name);
+				}
+				byUid.erase(last.data->uid);
+				entries.pop_back();
+			}
+		}
+	};
+
+	static Cache& cache() {
+		// Intentionally never destroyed
+		static Cache* instance = new Cache();
+		return *instance;
+	}
+
+	static std::shared_ptr<const UserFoldersData> empty() {
+		static const std::shared_ptr<const UserFoldersData> instance = std::make_shared<UserFoldersData>();
+		return instance;
+	}
+
+	/**
+	 * Builds the folders of a user. previous is reused for the home folder if set.
+	 */
+	static std::shared_ptr<const UserFoldersData> resolve(unsigned long uid, const UserFoldersData* previous, std::error_code& ec) {
+		std::shared_ptr<UserFoldersData> data = std::make_shared<UserFoldersData>();
+		data->uid = uid;
+		if (previous) {
+			data->home = previous->home;
+		}
+		else if (!internal::lookupHome(uid, data->home, ec)) {
+			return std::shared_ptr<const UserFoldersData>();
+		}
+		const std::string& home = data->home;
+		for (std::size_t i = 0; i < folderCount; ++i) {
+			data->folders[i] = home + internal::folderTable[i].homeRelative;
+		}
+#ifdef __APPLE__
+		data->baseDirs[static_cast<std::size_t>(BaseDir::Data)] = home + "/Library/Application Support";
+		data->baseDirs[static_cast<std::size_t>(BaseDir::Config)] = home + "/Library/Application Support";
+		data->baseDirs[static_cast<std::size_t>(BaseDir::Cache)] = home + "/Library/Caches";
+		data->baseDirs[static_cast<std::size_t>(BaseDir::State)] = home + "/Library/Application Support";
+#else
+		data->baseDirs[static_cast<std::size_t>(BaseDir::Data)] = home + "/.local/share";
+		data->baseDirs[static_cast<std::size_t>(BaseDir::Config)] = home + "/.config";
+		data->baseDirs[static_cast<std::size_t>(BaseDir::Cache)] = home + "/.cache";
+		data->baseDirs[static_cast<std::size_t>(BaseDir::State)] = home + "/.local/state";
+		data->userDirsPath = data->baseDirs[static_cast<std::size_t>(BaseDir::Config)] + "/user-dirs.dirs";
+		// Stamped before reading, so a change during the read is seen next time
+		data->stamp = stampUserDirs(data->userDirsPath);
+		int fd = openTrustedUserDirs(data->userDirsPath, uid);
+		if (fd < 0) {
+			return data;
+		}
+		UserFoldersData& filled = *data;
+		try {
+			internal::parseUserDirsFile(data->userDirsPath, fd, [&filled](const char* key, std::size_t keyLength, std::string& value, bool relativeToHome) {
+				if (relativeToHome) {
+					value.insert(0, filled.home);
+				}
+				// Only folders inside the home folder are used. The default is kept for anything else.
+				if (!internal::isInsideFolder(filled.home, value)) {
+					return;
+				}
+				for (std::size_t i = 0; i < folderCount; ++i) {
+					const char* xdgKey = internal::folderTable[i].xdgKey;
+					if (std::strlen(xdgKey) == keyLength && std::memcmp(xdgKey, key, keyLength) == 0) {
+						filled.folders[i].swap(value);
+						return;
+					}
+				}
+			});
+		}
+		catch (...) {
+			close(fd);
+			throw;
+		}
+		close(fd);
+#endif
+		return data;
+	}
+
+	static bool isCurrent(const UserFoldersData& data) {
+		return data.userDirsPath.empty() || stampUserDirs(data.userDirsPath) == data.stamp;
+	}
+
+	/**
+	 * Returns the folders of uid from the cache or resolves them.
+	 * @param userName Remembered as a name for uid if not empty
+	 * @return Null on failure. ec will then be set.
+	 */
+	static std::shared_ptr<const UserFoldersData> get(unsigned long uid, const std::string& userName, std::error_code& ec) {
+		Cache& c = cache();
+		std::shared_ptr<const UserFoldersData> cached;
+		unsigned long long generation;
+		{
+			std::lock_guard<std::mutex> lock(c.mutex);
+			c.checkGeneration();
+			generation = c.generation;
+			auto found = c.byUid.find(uid);
+			if (found != c.byUid.end()) {
+				c.entries.splice(c.entries.begin(), c.entries, found->second);
+				cached = found->second->data;
+			}
+		}
+		// The stat() is done without the lock
+		if (cached && isCurrent(*cached)) {
+			return cached;
+		}
+		std::shared_ptr<const UserFoldersData> data = resolve(uid, cached.get(), ec);
+		if (!data) {
+			return data;
+		}
+		std::lock_guard<std::mutex> lock(c.mutex);
+		c.checkGeneration();
+		if (c.generation != generation || c.limit == 0) {
+			// Invalidated while resolving. The result is still returned but not kept.
+			return data;
+		}
+		auto found = c.byUid.find(uid);
+		if (found != c.byUid.end()) {
+			found->second->data = data;
+			c.entries.splice(c.entries.begin(), c.entries, found->second);
+		}
+		else {
+			c.entries.push_front(Cache::Entry());
+			c.entries.front().data = data;
+			c.byUid[uid] = c.entries.begin();
+		}
+		if (!userName.empty() && c.uidByName.insert(std::make_pair(userName, uid)).second) {
+			c.entries.front().names.push_back(userName);
+		}
+		c.evict();
+		return data;
+	}
+
+	/**
+	 * @param uid Set to the uid of userName once it is known, also if resolving the folders fails afterwards
+	 */
+	static std::shared_ptr<const UserFoldersData> get(const std::string& userName, unsigned long& uid, std::error_code& ec) {
+		Cache& c = cache();
+		bool known = false;
+		{
+			std::lock_guard<std::mutex> lock(c.mutex);
+			c.checkGeneration();
+			auto found = c.uidByName.find(userName);
+			if (found != c.uidByName.end()) {
+				uid = found->second;
+				known = true;
+			}
+		}
+		if (!known && !internal::lookupUid(userName, uid, ec)) {
+			return std::shared_ptr<const UserFoldersData>();
+		}
+		return get(uid, userName, ec);
+	}
+};
+
+namespace {
+
+[[noreturn]] void throwUserError(const std::error_code& ec, const std::string& user) {
+	if (ec == std::errc::not_enough_memory) {
+		throw std::bad_alloc();
+	}
+	throw std::system_error(ec, "Unable to resolve the folders of user " + user);
+}
+
+}  // namespace
+
+UserFolders::UserFolders(unsigned long uid, std::error_code& ec) noexcept : uid(uid) {
+	ec.clear();
+	data = internal::noThrow(ec, [uid, &ec]() {
+		return UserFoldersData::get(uid, std::string(), ec);
+	});
+	if (!data) {
+		data = UserFoldersData::empty();
+	}
+}
+
+UserFolders::UserFolders(unsigned long uid) : uid(uid) {
+	std::error_code ec;
+	data = UserFoldersData::get(uid, std::string(), ec);
+	if (!data) {
+		throwUserError(ec, std::to_string(uid));
+	}
+}
+
+UserFolders::UserFolders(const std::string& userName, std::error_code& ec) noexcept : uid(unknownUid) {
+	unsigned long& found = uid;
+	ec.clear();
+	data = internal::noThrow(ec, [&userName, &found, &ec]() {
+		return UserFoldersData::get(userName, found, ec);
+	});
+	if (!data) {
+		data = UserFoldersData::empty();
+	}
+	try {
+		// Also kept on failure, so refresh() looks up the same name again
+		this->userName = userName;
+	}
+	catch (const std::bad_alloc&) {
+		ec = std::make_error_code(std::errc::not_enough_memory);
+		data = UserFoldersData::empty();
+	}
+}
+
+UserFolders::UserFolders(const std::string& userName) : uid(unknownUid), userName(userName) {
+	std::error_code ec;
+	data = UserFoldersData::get(userName, uid, ec);
+	if (!data) {
+		throwUserError(ec, "\"" + userName + "\"");
+	}
+}
+
+void UserFolders::refresh(std::error_code& ec) noexcept {
+	unsigned long& current = uid;
+	const std::string& name = userName;
+	ec.clear();
+	std::shared_ptr<const UserFoldersData> refreshed = internal::noThrow(ec, [&current, &name, &ec]() {
+		return name.empty() ? UserFoldersData::get(current, name, ec) : UserFoldersData::get(name, current, ec);
+	});
+	if (refreshed) {
+		data = refreshed;
+	}
+}
+
+void UserFolders::refresh() {
+	std::error_code ec;
+	refresh(ec);
+	if (ec) {
+		throwUserError(ec, userName.empty() ? std::to_string(uid) : "\"" + userName + "\"");
+	}
+}
+
+unsigned long UserFolders::getUid() const {
+	return uid;
+}
+
+const std::string& UserFolders::getHome() const {
+	return data->home;
+}
+
+const std::string& UserFolders::getBaseDir(BaseDir dir) const {
+	return data->baseDirs[static_cast<std::size_t>(dir)];
+}
+
+const std::string& UserFolders::getDataHome() const {
+	return getBaseDir(BaseDir::Data);
+}
+
+const std::string& UserFolders::getConfigHome() const {
+	return getBaseDir(BaseDir::Config);
+}
+
+const std::string& UserFolders::getCacheDir() const {
+	return getBaseDir(BaseDir::Cache);
+}
+
+const std::string& UserFolders::getStateDir() const {
+	return getBaseDir(BaseDir::State);
+}
+
+const std::string& UserFolders::getFolder(Folder folder) const {
+	return data->folders[static_cast<std::size_t>(folder)];
+}
+
+const std::string& UserFolders::getDesktopFolder() const {
+	return getFolder(Folder::Desktop);
+}
+
+const std::string& UserFolders::getDocumentsFolder() const {
+	return getFolder(Folder::Documents);
+}
+
+const std::string& UserFolders::getPicturesFolder() const {
+	return getFolder(Folder::Pictures);
+}
+
+const std::string& UserFolders::getPublicFolder() const {
+	return getFolder(Folder::Public);
+}
+
+const std::string& UserFolders::getDownloadFolder1() const {
+	return getFolder(Folder::Download);
+}
+
+const std::string& UserFolders::getMusicFolder() const {
+	return getFolder(Folder::Music);
+}
+
+const std::string& UserFolders::getVideoFolder() const {
+	return getFolder(Folder::Videos);
+}
+
+void setUserFoldersCacheLimit(std::size_t maxUsers) {
+	UserFolders::UserFoldersData::Cache& c = UserFolders::UserFoldersData::cache();
+	std::lock_guard<std::mutex> lock(c.mutex);
+	c.limit = maxUsers;
+	c.evict();
+}
+
+std::size_t getUserFoldersCacheSize() {
+	UserFolders::UserFoldersData::Cache& c = UserFolders::UserFoldersData::cache();
+	std::lock_guard<std::mutex> lock(c.mutex);
+	c.checkGeneration();
+	return c.entries.size();
+}
+
+}  // namespace sago
+
+#endif
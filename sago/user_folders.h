@@ -0,0 +1,163 @@
+/*
+Its is under the MIT license, to encourage reuse by cut-and-paste.
+
+The original files are hosted here: https://github.com/sago007/PlatformFolders
+
+Copyright (c) 2015 Poul Sander
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation files
+(the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SAGO_USER_FOLDERS_H
+#define SAGO_USER_FOLDERS_H
+
+#include "platform_folders.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <system_error>
+
+namespace sago {
+
+#ifndef _WIN32
+
+/**
+ * The folders of any user, looked up by uid or user name. Meant for services that run as root and work on behalf of
+ * many users.
+ * The environment of the process is not used. The folders are found from the user's home folder in the passwd
+ * database and, on Linux, from ~/.config/user-dirs.dirs. The XDG_* variables of the other user cannot be seen,
+ * so the base folders are always the XDG defaults.
+ *
+ * As the user controls user-dirs.dirs, it is only read if it is a regular file, not a symbolic link, owned by the
+ * user and not writable by the group or others. Entries that point outside the home folder or contain ".." are
+ * ignored and the default is used. A user with "/" as home folder gets the defaults for every entry. Symbolic links inside the home folder are not resolved, so a service running as
+ * root should still access the folders with the user's permissions.
+ *
+ * The resolved folders live in a process-wide cache that keeps the most recently used users. See
+ * setUserFoldersCacheLimit(). An entry is used again as long as the user's user-dirs.dirs has not changed.
+ * sago::invalidateFolderCache() empties it.
+ *
+ * An object keeps the folders it was created with. The returned references are valid until the object is destroyed
+ * or refreshed, also if the user is evicted from the cache. Copies are cheap and share the folders.
+ * @code{.cpp}
+ * sago::UserFolders user(request.uid);
+ * std::string cache = user.getCacheDir() + "/my_service";
+ * @endcode
+ * @note Not available on Windows
+ */
+class UserFolders {
+public:
+	/// What getUid() returns for an object created by a user name that was not found
+	static const unsigned long unknownUid = static_cast<unsigned long>(-1);
+	/**
+	 * Resolves the folders of a user.
+	 * @param uid The user
+	 * @throws std::system_error if the user has no home folder in the passwd database
+	 */
+	explicit UserFolders(unsigned long uid);
+	/**
+	 * Exception free version of UserFolders(unsigned long).
+	 * The getters return empty strings if ec is set. The uid is kept, so refresh() tries the same user again.
+	 * @param uid The user
+	 * @param ec Set if the folders could not be resolved, cleared otherwise
+	 */
+	UserFolders(unsigned long uid, std::error_code& ec) noexcept;
+	/**
+	 * Resolves the folders of a user by name.
+	 * A name is only looked up in the passwd database the first time. After that the cache knows its uid.
+	 * @param userName The login name of the user
+	 * @throws std::system_error if there is no such user or the user has no home folder
+	 */
+	explicit UserFolders(const std::string& userName);
+	/**
+	 * Exception free version of UserFolders(const std::string&).
+	 * The getters return empty strings if ec is set. The name is kept, so refresh() tries the same user again.
+	 * @param userName The login name of the user
+	 * @param ec Set if the folders could not be resolved, cleared otherwise
+	 */
+	UserFolders(const std::string& userName, std::error_code& ec) noexcept;
+	/**
+	 * Looks the user up in the cache again. Picks up changes to user-dirs.dirs.
+	 * @throws std::system_error if the folders could not be resolved. The old folders are kept.
+	 */
+	void refresh();
+	/**
+	 * Exception free version of refresh(). The old folders are kept if ec is set.
+	 * @param ec Set if the folders could not be resolved, cleared otherwise
+	 */
+	void refresh(std::error_code& ec) noexcept;
+	/**
+	 * @return The uid the object was created with or the uid of its user name. unknownUid if the name was not found.
+	 */
+	unsigned long getUid() const;
+	/**
+	 * @return The home folder from the passwd database
+	 */
+	const std::string& getHome() const;
+	/**
+	 * @param dir The base folder
+	 * @return Absolute path to the base folder of the user
+	 */
+	const std::string& getBaseDir(BaseDir dir) const;
+	const std::string& getDataHome() const;
+	const std::string& getConfigHome() const;
+	const std::string& getCacheDir() const;
+	const std::string& getStateDir() const;
+	/**
+	 * @param folder The folder to look up
+	 * @return Absolute path to the folder of the user
+	 */
+	const std::string& getFolder(Folder folder) const;
+	const std::string& getDesktopFolder() const;
+	const std::string& getDocumentsFolder() const;
+	const std::string& getPicturesFolder() const;
+	const std::string& getPublicFolder() const;
+	const std::string& getDownloadFolder1() const;
+	const std::string& getMusicFolder() const;
+	const std::string& getVideoFolder() const;
+private:
+	friend void setUserFoldersCacheLimit(std::size_t maxUsers);
+	friend std::size_t getUserFoldersCacheSize();
+	struct UserFoldersData;
+	std::shared_ptr<const UserFoldersData> data;
+	// Kept apart from data, as data holds no user if the folders could not be resolved
+	unsigned long uid;
+	// Set when created by name, so refresh() can tell the cache
+	std::string userName;
+};
+
+/**
+ * Sets how many users the cache used by UserFolders keeps. The least recently used users are evicted first.
+ * The default is 256.
+ * @param maxUsers The new limit. 0 disables the cache.
+ */
+void setUserFoldersCacheLimit(std::size_t maxUsers);
+
+/**
+ * @return The number of users currently in the cache used by UserFolders
+ */
+std::size_t getUserFoldersCacheSize();
+
+#endif
+
+}  //namespace sago
+
+#endif  /* SAGO_USER_FOLDERS_H */
@@ -0,0 +1,106 @@
+#include "tester.hpp"
+#include "../sago/app_folders.h"
+#include "../sago/platform_folders.h"
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static bool throws(const std::string& vendor, const std::string& app) {
+	try {
+		sago::AppFolders folders(vendor, app);
+	}
+	catch (const std::invalid_argument&) {
+		return true;
+	}
+	return false;
+}
+
+int main() {
+#ifdef _WIN32
+	const std::string sep = "\\";
+#else
+	const std::string sep = "/";
+#endif
+	sago::AppFolders app("Vendor", "App");
+	expectEqual("data", app.data().str(), sago::getDataHome() + sep + "Vendor" + sep + "App");
+	expectEqual("config", app.config().str(), sago::getConfigHome() + sep + "Vendor" + sep + "App");
+	expectEqual("cache", app.cache().str(), sago::getCacheDir() + sep + "Vendor" + sep + "App");
+	expectEqual("state", app.state().str(), sago::getStateDir() + sep + "Vendor" + sep + "App");
+	expectEqual("join", app.join(sago::BaseDir::Cache, "thumbs/1.png"), app.cache().str() + sep + "thumbs/1.png");
+	expectEqual("join string", app.join(sago::BaseDir::State, std::string("log")), app.state().str() + sep + "log");
+
+	sago::AppFolders noVendor("", "App");
+	expectEqual("no vendor", noVendor.config().str(), sago::getConfigHome() + sep + "App");
+
+	// Folders that are the same are shared
+	std::vector<sago::PathView> unique = app.uniqueFolders();
+	std::size_t expectedUnique = 0;
+	const sago::BaseDir dirs[] = { sago::BaseDir::Data, sago::BaseDir::Config, sago::BaseDir::Cache, sago::BaseDir::State };
+	for (std::size_t i = 0; i < 4; ++i) {
+		bool seen = false;
+		for (std::size_t j = 0; j < i; ++j) {
+			bool same = sago::getBaseDir(dirs[i]) == sago::getBaseDir(dirs[j]);
+			if (same != app.sameFolder(dirs[i], dirs[j])) {
+				fail("sameFolder() disagrees with the base folders");
+			}
+			if (same && app.get(dirs[i]).data() != app.get(dirs[j]).data()) {
+				fail("Equal folders are stored twice");
+			}
+			seen = seen || same;
+		}
+		if (!seen) {
+			++expectedUnique;
+		}
+	}
+	if (unique.size() != expectedUnique) {
+		fail("uniqueFolders() returned " + std::to_string(unique.size()) + " folders, expected " + std::to_string(expectedUnique));
+	}
+
+	// Copies do not point into the original
+	sago::AppFolders copy = noVendor;
+	noVendor = app;
+	expectEqual("copy", copy.config().str(), sago::getConfigHome() + sep + "App");
+
+	if (!throws("Vendor", "") || !throws("Ven/dor", "App") || !throws("Vendor", "A/pp")) {
+		fail("An invalid name was accepted");
+	}
+	if (!throws(".", "App") || !throws("..", "App") || !throws("Vendor", ".") || !throws("", "..")) {
+		fail("\".\" or \"..\" was accepted as a name");
+	}
+	if (throws("Vendor", ".App") || throws("Vendor", "App..")) {
+		fail("A name with dots was rejected");
+	}
+#if !defined(_WIN32) && !defined(__APPLE__)
+	{
+		// Data and config are the same folder here
+		FakeEnvironment env;
+		env.set(sago::Environment::Home, "/home/test")
+			.set(sago::Environment::XdgDataHome, "/shared")
+			.set(sago::Environment::XdgConfigHome, "/shared")
+			.set(sago::Environment::XdgCacheHome, "/cache");
+		sago::AppFolders shared("Vendor", "App");
+		if (!shared.sameFolder(sago::BaseDir::Data, sago::BaseDir::Config) || !shared.sameFolder(sago::BaseDir::Config, sago::BaseDir::Data)) {
+			fail("sameFolder() missed the shared folder");
+		}
+		if (shared.sameFolder(sago::BaseDir::Data, sago::BaseDir::Cache) || shared.sameFolder(sago::BaseDir::Config, sago::BaseDir::State)) {
+			fail("sameFolder() matched different folders");
+		}
+		if (shared.data().data() != shared.config().data()) {
+			fail("The shared folder is stored twice");
+		}
+		std::vector<sago::PathView> folders = shared.uniqueFolders();
+		if (folders.size() != 3) {
+			fail("uniqueFolders() returned " + std::to_string(folders.size()) + " folders, expected 3");
+		}
+		expectEqual("First unique folder", folders[0].str(), "/shared/Vendor/App");
+		expectEqual("Second unique folder", folders[1].str(), "/cache/Vendor/App");
+		expectEqual("Third unique folder", folders[2].str(), "/home/test/.local/state/Vendor/App");
+	}
+#endif
+	if (sago::PathView("ab", 1) != sago::PathView("ac", 1) || sago::PathView("ab", 2) == sago::PathView("ac", 2)) {
+		fail("PathView comparison is wrong");
+	}
+	return 0;
+}
@@ -0,0 +1,197 @@
+#include "tester.hpp"
+#include "../sago/atomic_writer.h"
+#include "../sago/platform_folders.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static bool exists(const std::string& path) {
+	return access(path.c_str(), F_OK) == 0;
+}
+
+static std::string readFile(const std::string& path) {
+	std::ifstream in(path.c_str());
+	if (!in) {
+		fail("Failed to open \"" + path + "\"");
+	}
+	std::stringstream ss;
+	ss << in.rdbuf();
+	return ss.str();
+}
+
+static void expectMode(const std::string& path, mode_t expected) {
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0) {
+		fail("Failed to stat \"" + path + "\"");
+	}
+	if ((st.st_mode & 07777) != expected) {
+		std::ostringstream message;
+		message << "\"" << path << "\" has mode " << std::oct << (st.st_mode & 07777) << " expected " << expected;
+		fail(message.str());
+	}
+}
+
+/** Number of directory entries apart from . and .. */
+static int entryCount(const std::string& path) {
+	DIR* dir = opendir(path.c_str());
+	if (!dir) {
+		fail("Failed to open \"" + path + "\"");
+	}
+	int count = 0;
+	while (struct dirent* entry = readdir(dir)) {
+		std::string name = entry->d_name;
+		if (name != "." && name != "..") {
+			++count;
+		}
+	}
+	closedir(dir);
+	return count;
+}
+#endif
+
+int main() {
+#ifndef _WIN32
+	TempFolder temp("atomic");
+	const std::string base = temp.path() + "/config";
+	FakeEnvironment env;
+	env.set(sago::Environment::Home, temp.path()).set(sago::Environment::XdgConfigHome, base);
+
+	const std::string folder = base + "/my_program";
+	{
+		sago::AtomicWriter writer(sago::BaseDir::Config, "my_program");
+		expectEqual("folder()", writer.folder(), folder);
+		writer.write("settings.ini", "first");
+		writer.write("profiles/default.ini", "profile");
+		writer.write("settings.ini", "second");
+		if (writer.pending() != 2) {
+			fail("Writing the same file twice was not merged");
+		}
+		if (exists(folder + "/settings.ini") || exists(folder + "/profiles/default.ini")) {
+			fail("A file appeared before commit()");
+		}
+		writer.commit();
+		if (writer.pending() != 0) {
+			fail("Files are still pending after commit()");
+		}
+		if (readFile(folder + "/settings.ini") != "second" || readFile(folder + "/profiles/default.ini") != "profile") {
+			fail("commit() did not write the last contents");
+		}
+
+		// Replaces existing files
+		writer.write("settings.ini", "third");
+		writer.write("empty.ini", "");
+		writer.commit();
+		if (readFile(folder + "/settings.ini") != "third" || readFile(folder + "/empty.ini") != "") {
+			fail("commit() did not replace an existing file");
+		}
+
+		writer.write("settings.ini", "discarded");
+		writer.discard();
+		if (writer.pending() != 0) {
+			fail("Files are still pending after discard()");
+		}
+		writer.commit();
+		if (readFile(folder + "/settings.ini") != "third") {
+			fail("A discarded file was written");
+		}
+
+		const char* invalid[] = { "", "/etc/passwd", "folder/", "..", "../escape.ini", "profiles/../../escape.ini", "./settings.ini", "profiles//default.ini" };
+		for (std::size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+			bool thrown = false;
+			try {
+				writer.write(invalid[i], "x");
+			}
+			catch (const std::runtime_error&) {
+				thrown = true;
+			}
+			if (!thrown) {
+				fail(std::string("The file name \"") + invalid[i] + "\" was accepted");
+			}
+		}
+
+		// Destroyed with pending files
+		writer.write("settings.ini", "destroyed");
+		writer.write("profiles/other.ini", "destroyed");
+	}
+	if (readFile(folder + "/settings.ini") != "third" || exists(folder + "/profiles/other.ini")) {
+		fail("The destructor committed pending files");
+	}
+	// No temporary files are left behind
+	if (entryCount(folder) != 3 || entryCount(folder + "/profiles") != 1) {
+		fail("Temporary files were left behind");
+	}
+
+	const char* invalidFolders[] = { "/absolute", "../escape", "my_program/../.." };
+	for (std::size_t i = 0; i < sizeof(invalidFolders) / sizeof(invalidFolders[0]); ++i) {
+		bool thrown = false;
+		try {
+			sago::AtomicWriter writer(sago::BaseDir::Config, invalidFolders[i]);
+		}
+		catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		if (!thrown) {
+			fail(std::string("The subfolder \"") + invalidFolders[i] + "\" was accepted");
+		}
+	}
+	if (exists(temp.path() + "/escape")) {
+		fail("A rejected subfolder was created");
+	}
+	{
+		sago::AtomicWriter writer(sago::BaseDir::Config);
+		expectEqual("folder()", writer.folder(), base);
+	}
+
+	{
+		// A replaced file keeps its permissions
+		sago::AtomicWriter writer(sago::BaseDir::Config, "modes");
+		writer.write("shared.ini", "first");
+		writer.commit();
+		expectMode(base + "/modes/shared.ini", 0600);
+		if (chmod((base + "/modes/shared.ini").c_str(), 0644) != 0) {
+			fail("chmod() failed");
+		}
+		writer.write("shared.ini", "second");
+		writer.commit();
+		expectMode(base + "/modes/shared.ini", 0644);
+		expectEqual("The replaced file", readFile(base + "/modes/shared.ini"), "second");
+	}
+
+	{
+		// A failed rename keeps that file and the ones after it staged
+		sago::AtomicWriter writer(sago::BaseDir::Config, "blocked");
+		writer.write("a.ini", "a");
+		writer.write("blocked.ini", "b");
+		writer.write("c.ini", "c");
+		const std::string blocked = base + "/blocked/blocked.ini";
+		if (mkdir(blocked.c_str(), 0700) != 0) {
+			fail("Failed to create " + blocked);
+		}
+		bool thrown = false;
+		try {
+			writer.commit();
+		}
+		catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		if (!thrown) {
+			fail("Replacing a folder with a file did not fail");
+		}
+		expectEqual("The file before the failure", readFile(base + "/blocked/a.ini"), "a");
+		if (writer.pending() != 2 || exists(base + "/blocked/c.ini")) {
+			fail("The files after the failure were not kept staged");
+		}
+		rmdir(blocked.c_str());
+		writer.commit();
+		expectEqual("The retried file", readFile(blocked), "b");
+		expectEqual("The file after the retry", readFile(base + "/blocked/c.ini"), "c");
+	}
+#endif
+	return 0;
+}
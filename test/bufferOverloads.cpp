@@ -0,0 +1,76 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <stdlib.h>
+#endif
+
+static unsigned long allocations = 0;
+
+void* operator new(std::size_t size) {
+	++allocations;
+	void* p = std::malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+typedef std::size_t (*BufferFunction)(char*, std::size_t, std::error_code&);
+
+static void compare(const char* name, BufferFunction bufferVersion, const std::string& expected) {
+	char buffer[4096];
+	std::error_code ec;
+	std::size_t length = bufferVersion(buffer, sizeof(buffer), ec);
+	if (ec || length != expected.size() || expected != buffer) {
+		fail(std::string(name) + " returned \"" + buffer + "\" expected \"" + expected + "\"");
+	}
+	// Too small. Must report the needed size and leave an empty string.
+	char small[2] = { 'x', 'x' };
+	length = bufferVersion(small, sizeof(small), ec);
+	if (ec != std::errc::result_out_of_range || length != expected.size() || small[0] != '\0') {
+		fail(std::string(name) + " did not report truncation");
+	}
+}
+
+int main() {
+	compare("getDataHome", sago::getDataHome, sago::getDataHome());
+	compare("getConfigHome", sago::getConfigHome, sago::getConfigHome());
+	compare("getCacheDir", sago::getCacheDir, sago::getCacheDir());
+	compare("getStateDir", sago::getStateDir, sago::getStateDir());
+	char buffer[4096];
+	std::error_code ec;
+	sago::getFolder(sago::Folder::Music, buffer, sizeof(buffer), ec);
+	if (ec || sago::getMusicFolder() != buffer) {
+		fail("getFolder(Music) does not match getMusicFolder()");
+	}
+	run_test(buffer);
+	unsigned long before = allocations;
+	for (int i = 0; i < 1000; ++i) {
+		sago::getDataHome(buffer, sizeof(buffer), ec);
+		sago::getCacheDir(buffer, sizeof(buffer), ec);
+		sago::getFolder(sago::Folder::Documents, buffer, sizeof(buffer), ec);
+	}
+	if (allocations != before) {
+		fail("The buffer versions allocated " + std::to_string(allocations - before) + " times");
+	}
+#if !defined(_WIN32) && !defined(__APPLE__)
+	setenv("XDG_CACHE_HOME", "relative/path", 1);
+	sago::invalidateFolderCache();
+	if (sago::getCacheDir(buffer, sizeof(buffer), ec) != 0 || ec != std::errc::invalid_argument) {
+		fail("A relative XDG_CACHE_HOME was not reported as invalid_argument");
+	}
+#endif
+	return 0;
+}
@@ -0,0 +1,161 @@
+#include "tester.hpp"
+#include "../sago/cache_store.h"
+#include "../sago/platform_folders.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+
+static void expectValue(sago::CacheStore& store, const std::string& key, const std::string& expected) {
+	std::string value;
+	if (!store.get(key, value)) {
+		fail("\"" + key + "\" was not found");
+	}
+	if (value != expected) {
+		fail("\"" + key + "\" was \"" + value + "\" expected \"" + expected + "\"");
+	}
+}
+
+static void expectMissing(sago::CacheStore& store, const std::string& key) {
+	std::string value;
+	if (store.get(key, value)) {
+		fail("\"" + key + "\" should not be in the cache");
+	}
+}
+#endif
+
+int main() {
+#ifndef _WIN32
+	TempFolder temp("cache_store");
+	const std::string& root = temp.path();
+	FakeEnvironment env;
+	env.set(sago::Environment::Home, root).set(sago::Environment::XdgCacheHome, root);
+
+	{
+		sago::CacheStore store("basic");
+		expectEqual("folder()", store.folder(), root + "/basic");
+		expectMissing(store, "a");
+		store.put("a", "first");
+		store.put("b", std::string("bin\0ary", 7));
+		expectValue(store, "a", "first");
+		expectValue(store, "b", std::string("bin\0ary", 7));
+		store.put("a", "second");
+		expectValue(store, "a", "second");
+		if (store.entryCount() != 2) {
+			fail("Expected 2 entries, got " + std::to_string(store.entryCount()));
+		}
+		if (!store.remove("a") || store.remove("a")) {
+			fail("remove() returned the wrong value");
+		}
+		expectMissing(store, "a");
+
+		// A second instance works like another process. It sees the first one's changes.
+		sago::CacheStore other("basic");
+		expectValue(other, "b", std::string("bin\0ary", 7));
+		other.put("c", "from other");
+		expectValue(store, "c", "from other");
+	}
+
+	{
+		// Reopening reads the index
+		sago::CacheStore store("basic");
+		if (store.entryCount() != 2) {
+			fail("The index was not persisted");
+		}
+		// A lost index is rebuilt from the shard folders
+		std::remove((store.folder() + "/index").c_str());
+		sago::CacheStore rebuilt("basic");
+		if (rebuilt.entryCount() != 2) {
+			fail("The rebuilt index has " + std::to_string(rebuilt.entryCount()) + " entries");
+		}
+		expectValue(rebuilt, "c", "from other");
+		// A torn record at the end is dropped
+		{
+			std::ofstream out((store.folder() + "/index").c_str(), std::ios::app | std::ios::binary);
+			out << "torn";
+		}
+		sago::CacheStore torn("basic");
+		if (torn.entryCount() != 2) {
+			fail("A torn index record broke the index");
+		}
+		// A damaged header is rebuilt
+		{
+			std::ofstream out((store.folder() + "/index").c_str(), std::ios::trunc | std::ios::binary);
+			out << "garbage!";
+		}
+		sago::CacheStore damaged("basic");
+		if (damaged.entryCount() != 2) {
+			fail("A damaged index was not rebuilt");
+		}
+		expectValue(damaged, "b", std::string("bin\0ary", 7));
+	}
+
+	{
+		// The least recently used entries are evicted
+		sago::CacheStoreLimits limits;
+		limits.maxEntries = 4;
+		sago::CacheStore store("lru", limits);
+		store.put("1", "x");
+		usleep(1000);
+		store.put("2", "x");
+		usleep(1000);
+		store.put("3", "x");
+		usleep(1000);
+		store.put("4", "x");
+		usleep(1000);
+		store.put("5", "x");
+		if (store.entryCount() > 4) {
+			fail("The entry budget was exceeded");
+		}
+		expectMissing(store, "1");
+		expectValue(store, "5", "x");
+
+		limits = sago::CacheStoreLimits();
+		limits.maxBytes = 1000;
+		sago::CacheStore bytes("bytes", limits);
+		for (int i = 0; i < 20; ++i) {
+			bytes.put("key" + std::to_string(i), std::string(100, 'v'));
+		}
+		if (bytes.totalBytes() > 1000) {
+			fail("The size budget was exceeded: " + std::to_string(bytes.totalBytes()));
+		}
+		expectValue(bytes, "key19", std::string(100, 'v'));
+		expectMissing(bytes, "key0");
+	}
+
+	{
+		// Two processes writing at the same time
+		sago::CacheStore store("shared");
+		std::cout.flush();
+		pid_t child = fork();
+		if (child < 0) {
+			fail("fork() failed");
+		}
+		const char* prefix = child == 0 ? "child" : "parent";
+		{
+			sago::CacheStore mine("shared");
+			for (int i = 0; i < 50; ++i) {
+				mine.put(prefix + std::to_string(i), prefix);
+			}
+		}
+		if (child == 0) {
+			_exit(0);
+		}
+		int status = 0;
+		waitpid(child, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			fail("The child process failed");
+		}
+		if (store.entryCount() != 100) {
+			fail("Expected 100 entries from two processes, got " + std::to_string(store.entryCount()));
+		}
+		expectValue(store, "child49", "child");
+		expectValue(store, "parent0", "parent");
+	}
+#endif
+	return 0;
+}
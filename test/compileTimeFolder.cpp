@@ -0,0 +1,47 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <cstring>
+#include <string>
+
+// The table is usable in constant expressions
+static_assert(sago::getFolderInfo(sago::Folder::Music).xdgKey[4] == 'M', "Wrong XDG key for Music");
+static_assert(sago::getFolderInfo(sago::Folder::Videos).homeRelative[0] == '/', "Home relative defaults start with a slash");
+
+template <sago::Folder F>
+static void expectSame() {
+	expectEqual("get<" + std::to_string(static_cast<int>(F)) + ">()", sago::get<F>(), sago::getFolder(F));
+}
+
+int main() {
+	expectSame<sago::Folder::Desktop>();
+	expectSame<sago::Folder::Documents>();
+	expectSame<sago::Folder::Download>();
+	expectSame<sago::Folder::Music>();
+	expectSame<sago::Folder::Pictures>();
+	expectSame<sago::Folder::Public>();
+	expectSame<sago::Folder::Templates>();
+	expectSame<sago::Folder::Videos>();
+	if (std::strcmp(sago::getFolderInfo(sago::Folder::Public).xdgKey, "XDG_PUBLICSHARE_DIR") != 0) {
+		fail("Wrong XDG key for Public");
+	}
+#if !defined(_WIN32) && !defined(__APPLE__)
+	TempFolder root("compile_time");
+	const std::string& base = root.path();
+	FakeEnvironment env;
+	env.set(sago::Environment::Home, base).set(sago::Environment::XdgConfigHome, base);
+	const std::string before = sago::get<sago::Folder::Music>();
+	if (before != base + "/Music") {
+		fail("get<Folder::Music>() returned \"" + before + "\" without user-dirs.dirs");
+	}
+	writeFile(base + "/user-dirs.dirs", "XDG_MUSIC_DIR=\"$HOME/Songs\"\n");
+	// Still cached
+	if (sago::get<sago::Folder::Music>() != base + "/Music") {
+		fail("get<>() read user-dirs.dirs again");
+	}
+	sago::invalidateFolderCache();
+	if (sago::get<sago::Folder::Music>() != base + "/Songs") {
+		fail("get<>() did not see the invalidated cache");
+	}
+#endif
+	return 0;
+}
@@ -0,0 +1,42 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Readers share one PlatformFolders and the process-wide cache while the main thread refreshes both.
+// Build with -DPLATFORMFOLDERS_ENABLE_TSAN=ON to have ThreadSanitizer check for races.
+int main() {
+	sago::PlatformFolders shared;
+	const std::string documents = shared.getDocumentsFolder();
+	std::atomic<bool> done(false);
+	std::atomic<int> failures(0);
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 8; ++t) {
+		readers.push_back(std::thread([&]() {
+			while (!done.load()) {
+				if (shared.getDocumentsFolder() != documents || sago::getDocumentsFolder() != documents) {
+					++failures;
+				}
+				run_test(shared.getMusicFolder());
+				run_test(sago::getDesktopFolder());
+			}
+		}));
+	}
+	for (int i = 0; i < 200; ++i) {
+		shared.refresh();
+		sago::invalidateFolderCache();
+	}
+	done = true;
+	for (std::thread& t : readers) {
+		t.join();
+	}
+	if (failures.load() != 0) {
+		std::cerr << "Readers saw " << failures.load() << " inconsistent values during refresh\n";
+		return EXIT_FAILURE;
+	}
+	return 0;
+}
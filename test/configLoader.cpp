@@ -0,0 +1,108 @@
+#include "tester.hpp"
+#include "../sago/config_loader.h"
+#include "../sago/platform_folders.h"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+
+static std::string overlay(const sago::ConfigLayers& layers) {
+	std::string result;
+	for (sago::ConfigLayers::OverlayIterator itr = layers.begin(); itr != layers.end(); ++itr) {
+		result += std::to_string(itr->layer) + ":" + itr->str() + "|";
+	}
+	return result;
+}
+#endif
+
+int main() {
+#ifndef _WIN32
+	TempFolder root("config");
+	const std::string& base = root.path();
+	root.makeFolder("home/my_program");
+	root.makeFolder("site/my_program");
+	root.makeFolder("xdg/my_program");
+	FakeEnvironment env;
+	env.set(sago::Environment::Home, base + "/nobody");
+	env.set(sago::Environment::XdgConfigHome, base + "/home");
+	env.set(sago::Environment::XdgConfigDirs, base + "/site:" + base + "/missing:" + base + "/xdg/");
+
+	sago::ConfigLoader loader("my_program", "settings.ini");
+	std::vector<std::string> paths = loader.paths();
+	if (paths.size() != 4 || paths[0] != base + "/home/my_program/settings.ini" || paths[3] != base + "/xdg/my_program/settings.ini") {
+		fail("paths() returned the wrong paths");
+	}
+	if (!loader.load().empty()) {
+		fail("Layers were found before any file exists");
+	}
+
+	writeFile(base + "/home/my_program/settings.ini", "a=home\r\n");
+	writeFile(base + "/xdg/my_program/settings.ini", "a=xdg\nb=xdg\n\nc=xdg");
+	writeFile(base + "/site/my_program/settings.ini", "");
+	sago::ConfigLayers first = loader.load();
+	if (first.size() != 3 || first[0].path != paths[0] || first[1].size != 0 || first[2].path != paths[3]) {
+		fail("load() returned the wrong layers");
+	}
+	if (std::string(first[0].data, first[0].size) != "a=home\r\n") {
+		fail("The first layer has the wrong contents");
+	}
+	std::string expected = "2:a=xdg|2:b=xdg|2:|2:c=xdg|0:a=home|";
+	if (overlay(first) != expected) {
+		fail("The overlay iterator returned " + overlay(first));
+	}
+	if (first.begin() == first.end() || sago::ConfigLayers().begin() != sago::ConfigLayers().end()) {
+		fail("begin() and end() are wrong");
+	}
+
+	// Unchanged files are not mapped again
+	sago::ConfigLayers second = loader.load();
+	if (second[0].data != first[0].data || second[2].data != first[2].data) {
+		fail("An unchanged layer was mapped again");
+	}
+
+	// A file replaced like an editor would is mapped again. The old layers keep their contents.
+	writeFile(base + "/home/my_program/settings.ini", "a=changed\n");
+	std::remove((base + "/site/my_program/settings.ini").c_str());
+	sago::ConfigLayers third = loader.load();
+	if (third.size() != 2 || std::string(third[0].data, third[0].size) != "a=changed\n" || third[1].data != first[2].data) {
+		fail("A changed layer was not mapped again");
+	}
+	if (overlay(first) != expected) {
+		fail("An old mapping changed");
+	}
+
+	// The folders are looked up again when the environment changes
+	env.unset(sago::Environment::XdgConfigDirs);
+	if (loader.paths().size() != 2 || loader.load().size() != 1) {
+		fail("The folders were not looked up again");
+	}
+
+	// A file that a user can write is copied. Truncating it in place must not break the layers that were loaded.
+	const std::string userFile = base + "/home/my_program/settings.ini";
+	const std::string longContents = std::string(3 * 4096, 'x') + "\n";
+	writeFile(userFile, longContents);
+	if (geteuid() == 0 && chown(userFile.c_str(), 4242, 4242) != 0) {
+		fail("Failed to give the config file to another user");
+	}
+	sago::ConfigLayers beforeTruncation = loader.load();
+	overwriteFile(userFile, "a=short\n");
+	expectEqual("A layer truncated in place", std::string(beforeTruncation[0].data, beforeTruncation[0].size), longContents);
+	sago::ConfigLayers afterTruncation = loader.load();
+	expectEqual("The truncated layer", std::string(afterTruncation[0].data, afterTruncation[0].size), "a=short\n");
+
+	bool thrown = false;
+	try {
+		sago::ConfigLoader absolute("", "/etc/passwd");
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	if (!thrown) {
+		fail("An absolute file name was accepted");
+	}
+#endif
+	return 0;
+}
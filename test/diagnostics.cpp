@@ -0,0 +1,66 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::size_t countOccurrences(const std::string& haystack, const std::string& needle) {
+	std::size_t count = 0;
+	for (std::size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1)) {
+		++count;
+	}
+	return count;
+}
+
+int main() {
+#if !defined(_WIN32) && !defined(__APPLE__)
+	std::vector<std::string> folders;
+	// The default sink writes each distinct message once
+	std::ostringstream captured;
+	std::streambuf* original = std::cerr.rdbuf(captured.rdbuf());
+	unsigned long long before = sago::getDiagnosticCount();
+	for (int i = 0; i < 100; ++i) {
+		sago::internal::appendExtraFoldersTokenizer("XDG_DATA_DIRS", "relative/one:/usr/share", folders);
+	}
+	sago::internal::appendExtraFoldersTokenizer("XDG_DATA_DIRS", "relative/two", folders);
+	std::cerr.rdbuf(original);
+	if (sago::getDiagnosticCount() != before + 101) {
+		fail("Expected 101 diagnostics, got " + std::to_string(sago::getDiagnosticCount() - before));
+	}
+	if (countOccurrences(captured.str(), "relative/one") != 1 || countOccurrences(captured.str(), "relative/two") != 1) {
+		fail("The default sink did not write each message exactly once:\n" + captured.str());
+	}
+
+	// A custom sink gets everything
+	std::vector<std::string> messages;
+	std::vector<sago::Diagnostic> kinds;
+	sago::setDiagnosticSink([&messages, &kinds](sago::Diagnostic kind, const char* message) {
+		kinds.push_back(kind);
+		messages.push_back(message);
+	});
+	sago::internal::appendExtraFoldersTokenizer("XDG_DATA_DIRS", "relative/one", folders);
+	sago::internal::appendExtraFoldersTokenizer("XDG_DATA_DIRS", "relative/one", folders);
+	const char userDirs[] = "XDG_DESKTOP_DIR=\"$HOME/Desktop\n";
+	sago::internal::parseUserDirs("user-dirs.dirs", userDirs, sizeof(userDirs) - 1, [](const char*, std::size_t, std::string&, bool) {});
+	if (messages.size() != 3 || kinds[0] != sago::Diagnostic::RelativePathInList || kinds[2] != sago::Diagnostic::InvalidUserDirsLine) {
+		fail("The custom sink did not receive the expected diagnostics");
+	}
+	if (messages[0].find("relative/one") == std::string::npos || messages[0].find("XDG_DATA_DIRS") == std::string::npos) {
+		fail("Unexpected message: " + messages[0]);
+	}
+
+	// Silenced diagnostics are counted but never reach std::cerr
+	sago::setDiagnosticSink(sago::DiagnosticSink());
+	std::ostringstream silent;
+	original = std::cerr.rdbuf(silent.rdbuf());
+	before = sago::getDiagnosticCount();
+	sago::internal::appendExtraFoldersTokenizer("XDG_DATA_DIRS", "relative/three", folders);
+	std::cerr.rdbuf(original);
+	if (sago::getDiagnosticCount() != before + 1 || !silent.str().empty() || messages.size() != 3) {
+		fail("Silenced diagnostics were written or not counted");
+	}
+	sago::resetDiagnosticSink();
+#endif
+	return 0;
+}
@@ -0,0 +1,107 @@
+#include "tester.hpp"
+#include "../sago/ensure_folder.h"
+#include "../sago/platform_folders.h"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void expectFolder(const std::string& path, mode_t mode) {
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+		fail("\"" + path + "\" is not a folder");
+	}
+	if ((st.st_mode & 0777) != mode) {
+		fail("\"" + path + "\" has the wrong mode");
+	}
+}
+
+static bool throws(const std::string& path) {
+	try {
+		sago::ensureFolder(path);
+	}
+	catch (const std::runtime_error&) {
+		return true;
+	}
+	return false;
+}
+
+static bool subfolderThrows(std::string (*ensure)(const std::string&), const std::string& subfolder) {
+	try {
+		ensure(subfolder);
+	}
+	catch (const std::runtime_error&) {
+		return true;
+	}
+	return false;
+}
+#endif
+
+int main() {
+#ifndef _WIN32
+	TempFolder root("ensure");
+	const std::string& base = root.path();
+	chmod(base.c_str(), 0755);
+	std::string created = sago::ensureFolder(base + "//a/b//c/");
+	if (created != base + "/a/b/c") {
+		fail("ensureFolder() returned \"" + created + "\"");
+	}
+	expectFolder(base + "/a", 0700);
+	expectFolder(base + "/a/b/c", 0700);
+	// The existing root keeps its mode
+	expectFolder(base, 0755);
+
+	// Known folders are not checked again. A folder removed behind our back is only noticed after forgetting.
+	rmdir((base + "/a/b/c").c_str());
+	sago::ensureFolder(base + "/a/b/c");
+	struct stat st;
+	if (stat((base + "/a/b/c").c_str(), &st) == 0) {
+		fail("A known folder was checked again");
+	}
+	sago::forgetEnsuredFolders();
+	sago::ensureFolder(base + "/a/b/c");
+	expectFolder(base + "/a/b/c", 0700);
+	// Also works when starting from a known parent where some of the rest already exists
+	sago::ensureFolder(base + "/a/b/c/d");
+	expectFolder(base + "/a/b/c/d", 0700);
+
+	if (!throws("relative/path") || !throws("")) {
+		fail("A relative path was accepted");
+	}
+	if (!throws(base + "/a/../escaped") || !throws(base + "/a/./b") || !throws(base + "/..")) {
+		fail("A path with . or .. was accepted");
+	}
+	// A file in the way
+	std::fclose(std::fopen((base + "/file").c_str(), "w"));
+	if (!throws(base + "/file/sub")) {
+		fail("A file was accepted as a parent folder");
+	}
+	std::remove((base + "/file").c_str());
+
+	FakeEnvironment env;
+	env.set(sago::Environment::Home, base + "/home");
+	std::string cache = sago::ensureCacheDir("my_program/thumbnails");
+	if (cache != base + "/home/.cache/my_program/thumbnails") {
+		fail("ensureCacheDir() returned \"" + cache + "\"");
+	}
+	expectFolder(cache, 0700);
+	expectFolder(sago::ensureConfigHome(), 0700);
+	expectFolder(sago::ensureDataHome("my_program"), 0700);
+	expectFolder(sago::ensureStateDir("my_program"), 0700);
+	if (!subfolderThrows(sago::ensureStateDir, "/absolute")) {
+		fail("An absolute subfolder was accepted");
+	}
+	// A subfolder must stay inside its base folder
+	if (!subfolderThrows(sago::ensureDataHome, "../x") || !subfolderThrows(sago::ensureCacheDir, "my_program/../..") ||
+			!subfolderThrows(sago::ensureConfigHome, ".")) {
+		fail("A subfolder with . or .. was accepted");
+	}
+	if (stat((base + "/home/.local/x").c_str(), &st) == 0) {
+		fail("ensureDataHome(\"../x\") created a folder outside the data folder");
+	}
+#endif
+	return 0;
+}
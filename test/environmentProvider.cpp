@@ -0,0 +1,82 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+int main() {
+	sago::Environment env;
+	if (env.get(sago::Environment::Home) || env.getUid() != 0) {
+		std::cerr << "A new Environment is not empty\n";
+		return EXIT_FAILURE;
+	}
+	env.set(sago::Environment::XdgDataHome, "/first");
+	env.set(sago::Environment::XdgDataHome, "/second");
+	expectEqual("Replaced value", env.get(sago::Environment::XdgDataHome), "/second");
+	env.unset(sago::Environment::XdgDataHome);
+	if (env.get(sago::Environment::XdgDataHome)) {
+		std::cerr << "unset() did not remove the value\n";
+		return EXIT_FAILURE;
+	}
+	expectEqual("Name", sago::Environment::name(sago::Environment::XdgConfigDirs), "XDG_CONFIG_DIRS");
+#ifndef _WIN32
+	// A fake environment. Nothing here exists on the machine running the test.
+	sago::Environment fake;
+	fake.setUid(4242);
+	fake.set(sago::Environment::Home, "/fake/home");
+	fake.set(sago::Environment::XdgCacheHome, "/fake/cache");
+	fake.set(sago::Environment::XdgConfigHome, "/fake/config");
+	fake.set(sago::Environment::XdgDataDirs, "/fake/data1:/fake/data2");
+	int captures = 0;
+	sago::setEnvironmentProvider([&fake, &captures]() {
+		++captures;
+		return fake;
+	});
+	expectEqual("getHome()", sago::internal::getHome(), "/fake/home");
+	expectEqual("getCacheDir()", sago::getCacheDir(), "/fake/cache");
+	expectEqual("getConfigHome()", sago::getConfigHome(), "/fake/config");
+#ifndef __APPLE__
+	expectEqual("getDataHome()", sago::getDataHome(), "/fake/home/.local/share");
+	expectEqual("getStateDir()", sago::getStateDir(), "/fake/home/.local/state");
+	// There is no /fake/config/user-dirs.dirs so the defaults are used
+	expectEqual("getDocumentsFolder()", sago::getDocumentsFolder(), "/fake/home/Documents");
+	std::vector<std::string> dataDirs;
+	sago::appendAdditionalDataDirectories(dataDirs);
+	if (dataDirs.size() != 2 || dataDirs[0] != "/fake/data1" || dataDirs[1] != "/fake/data2") {
+		std::cerr << "appendAdditionalDataDirectories() did not use the fake XDG_DATA_DIRS\n";
+		return EXIT_FAILURE;
+	}
+	sago::AllFolders all;
+	sago::getAllFolders(all);
+	expectEqual("AllFolders::configHome", all.configHome, "/fake/config");
+	expectEqual("AllFolders Documents", all.folder(sago::Folder::Documents), "/fake/home/Documents");
+#endif
+	if (captures != 1) {
+		std::cerr << "The environment was captured " << captures << " times, expected once\n";
+		return EXIT_FAILURE;
+	}
+	// The snapshot is kept until the cache is invalidated
+	fake.set(sago::Environment::XdgCacheHome, "/fake/other");
+	expectEqual("getCacheDir() before invalidate", sago::getCacheDir(), "/fake/cache");
+	sago::invalidateFolderCache();
+	expectEqual("getCacheDir() after invalidate", sago::getCacheDir(), "/fake/other");
+	// Root ignores HOME
+	fake.setUid(0);
+	sago::invalidateFolderCache();
+	if (sago::internal::getHome() == "/fake/home") {
+		std::cerr << "HOME was used for root\n";
+		return EXIT_FAILURE;
+	}
+	sago::setEnvironmentProvider(sago::EnvironmentProvider());
+	if (sago::getEnvironment()->getUid() != getuid()) {
+		std::cerr << "The default provider did not capture the uid\n";
+		return EXIT_FAILURE;
+	}
+#endif
+	return 0;
+}
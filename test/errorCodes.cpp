@@ -0,0 +1,124 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+static void expectSuccess(const std::string& name, const std::string& value, const std::error_code& ec, const std::string& expected) {
+	if (ec) {
+		fail(name + " failed with " + ec.message());
+	}
+	if (value != expected) {
+		fail(name + " returned \"" + value + "\" expected \"" + expected + "\"");
+	}
+}
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+static void expectFailure(const std::string& name, const std::string& value, const std::error_code& ec, std::errc expected) {
+	if (ec != expected) {
+		fail(name + " did not fail with " + std::make_error_code(expected).message() + " but with \"" + ec.message() + "\"");
+	}
+	if (!value.empty()) {
+		fail(name + " returned \"" + value + "\" on failure");
+	}
+}
+
+template <class Function>
+static void expectThrows(const std::string& name, Function function, std::errc expected, const char* messagePart) {
+	try {
+		function();
+	}
+	catch (const std::system_error& e) {
+		if (e.code() != expected) {
+			fail(name + " threw the wrong code: " + e.code().message());
+		}
+		if (std::string(e.what()).find(messagePart) == std::string::npos) {
+			fail(name + " threw \"" + e.what() + "\"");
+		}
+		return;
+	}
+	fail(name + " did not throw");
+}
+#endif
+
+int main() {
+	// Success: the error code versions return the same as the throwing versions
+	std::error_code ec;
+	expectSuccess("getDataHome(ec)", sago::getDataHome(ec), ec, sago::getDataHome());
+	expectSuccess("getConfigHome(ec)", sago::getConfigHome(ec), ec, sago::getConfigHome());
+	expectSuccess("getCacheDir(ec)", sago::getCacheDir(ec), ec, sago::getCacheDir());
+	expectSuccess("getStateDir(ec)", sago::getStateDir(ec), ec, sago::getStateDir());
+	expectSuccess("getBaseDir(ec)", sago::getBaseDir(sago::BaseDir::Cache, ec), ec, sago::getCacheDir());
+	expectSuccess("getDocumentsFolder(ec)", sago::getDocumentsFolder(ec), ec, sago::getDocumentsFolder());
+	expectSuccess("getMusicFolder(ec)", sago::getMusicFolder(ec), ec, sago::getMusicFolder());
+	expectSuccess("getFolder(ec)", sago::getFolder(sago::Folder::Videos, ec), ec, sago::getVideoFolder());
+	expectSuccess("get<Folder::Pictures>(ec)", sago::get<sago::Folder::Pictures>(ec), ec, sago::getPicturesFolder());
+	expectSuccess("getSaveGamesFolder2(ec)", sago::getSaveGamesFolder2(ec), ec, sago::getSaveGamesFolder2());
+	sago::PlatformFolders pf;
+	expectSuccess("PlatformFolders::getFolder(ec)", pf.getFolder(sago::Folder::Desktop, ec), ec, sago::getDesktopFolder());
+	std::vector<std::string> folders;
+	sago::appendAdditionalDataDirectories(folders, sago::FolderListDefault, ec);
+	std::vector<std::string> expected;
+	sago::appendAdditionalDataDirectories(expected);
+	if (ec || folders != expected) {
+		fail("appendAdditionalDataDirectories(ec) did not match");
+	}
+	sago::AllFolders all;
+	sago::getAllFolders(all, ec);
+	expectSuccess("getAllFolders(ec)", all.configHome, ec, sago::getConfigHome());
+	sago::getBaseDir(static_cast<sago::BaseDir>(42), ec);
+	if (ec != std::errc::invalid_argument) {
+		fail("getBaseDir(ec) accepted an unknown BaseDir");
+	}
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+	// A relative XDG variable
+	FakeEnvironment env;
+	env.set(sago::Environment::Home, "/home/test");
+	env.set(sago::Environment::XdgConfigHome, "relative/config");
+	expectFailure("getConfigHome(ec)", sago::getConfigHome(ec), ec, std::errc::invalid_argument);
+	expectSuccess("getDataHome(ec)", sago::getDataHome(ec), ec, "/home/test/.local/share");
+	// The user folders are read from the config folder
+	expectFailure("getDocumentsFolder(ec)", sago::getDocumentsFolder(ec), ec, std::errc::invalid_argument);
+	expectFailure("get<Folder::Music>(ec)", sago::get<sago::Folder::Music>(ec), ec, std::errc::invalid_argument);
+	sago::getAllFolders(all, ec);
+	if (ec != std::errc::invalid_argument) {
+		fail("getAllFolders(ec) accepted a relative XDG_CONFIG_HOME");
+	}
+	expectThrows("getConfigHome()", []() { sago::getConfigHome(); }, std::errc::invalid_argument, "XDG_CONFIG_HOME");
+	expectThrows("getDocumentsFolder()", []() { sago::getDocumentsFolder(); }, std::errc::invalid_argument, "XDG_CONFIG_HOME");
+	expectThrows("get<Folder::Music>()", []() { sago::get<sago::Folder::Music>(); }, std::errc::invalid_argument, "XDG_CONFIG_HOME");
+	expectThrows("getAllFolders()", [&all]() { sago::getAllFolders(all); }, std::errc::invalid_argument, "relative/config");
+	// Existing handlers for std::runtime_error still work
+	bool thrown = false;
+	try {
+		sago::getConfigHome();
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	if (!thrown) {
+		fail("getConfigHome() did not throw a std::runtime_error");
+	}
+
+	// A uid without a passwd entry and no HOME
+	env.unset(sago::Environment::Home);
+	env.unset(sago::Environment::XdgConfigHome);
+	env.setUid(0x7ffffff0);
+	std::string home = sago::internal::getHome(ec);
+	if (!ec || !home.empty()) {
+		fail("getHome(ec) found a home folder for a missing user");
+	}
+	expectFailure("getCacheDir(ec)", sago::getCacheDir(ec), ec, std::errc::no_such_file_or_directory);
+	pf.refresh(ec);
+	if (ec != std::errc::no_such_file_or_directory) {
+		fail("PlatformFolders::refresh(ec) did not fail");
+	}
+	expectThrows("getCacheDir()", []() { sago::getCacheDir(); }, std::errc::no_such_file_or_directory, "home");
+	// Failures are not cached
+	env.set(sago::Environment::Home, "/home/test");
+	expectSuccess("getDesktopFolder(ec)", sago::getDesktopFolder(ec), ec, "/home/test/Desktop");
+#endif
+	return 0;
+}
@@ -0,0 +1,90 @@
+#include "tester.hpp"
+#include "../sago/file_finder.h"
+#include "../sago/platform_folders.h"
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+static void touch(const std::string& path) {
+	writeFile(path, "x");
+}
+#endif
+
+int main() {
+#ifndef _WIN32
+	TempFolder root("finder");
+	const std::string home = root.makeFolder("home");
+	const std::string first = root.makeFolder("first");
+	const std::string second = root.makeFolder("second");
+	const std::string config = root.makeFolder("config");
+	root.makeFolder("second/app");
+	touch(home + "/only_home");
+	touch(first + "/shared");
+	touch(second + "/shared");
+	touch(second + "/app/deep");
+	touch(config + "/settings.ini");
+
+	FakeEnvironment env;
+	env.set(sago::Environment::Home, home);
+	env.set(sago::Environment::XdgDataHome, home);
+	env.set(sago::Environment::XdgConfigHome, config);
+	// A missing folder, a duplicate and a trailing slash
+	env.set(sago::Environment::XdgDataDirs, first + ":" + root.path() + "/missing:" + home + ":" + second + "/");
+	env.set(sago::Environment::XdgConfigDirs, first);
+
+	sago::FileFinder finder(sago::SearchPath::Data);
+#ifndef __APPLE__
+	std::vector<std::string> folders = finder.folders();
+	if (folders.size() != 3 || folders[0] != home || folders[1] != first || folders[2] != second) {
+		fail("Unexpected search folders");
+	}
+	expectEqual("find(shared)", finder.find("shared"), first + "/shared");
+	expectEqual("find(app/deep)", finder.find("app/deep"), second + "/app/deep");
+	std::vector<std::string> all = finder.findAll("shared");
+	if (all.size() != 2 || all[0] != first + "/shared" || all[1] != second + "/shared") {
+		fail("findAll(shared) returned the wrong files");
+	}
+	expectEqual("findConfigFile", sago::findConfigFile("settings.ini"), config + "/settings.ini");
+	expectEqual("findDataFile", sago::findDataFile("app/deep"), second + "/app/deep");
+	if (sago::findAll(sago::SearchPath::Config, "shared").size() != 1) {
+		fail("findAll(Config, shared) did not search XDG_CONFIG_DIRS");
+	}
+
+	std::vector<std::string> names;
+	names.push_back("only_home");
+	names.push_back("missing");
+	names.push_back("app/deep");
+	names.push_back("/etc/passwd");
+	names.push_back("shared");
+	std::vector<std::string> results;
+	finder.findMany(names, results);
+	if (results.size() != 5 || results[0] != home + "/only_home" || !results[1].empty() || results[2] != second + "/app/deep"
+			|| !results[3].empty() || results[4] != first + "/shared") {
+		fail("findMany() returned the wrong files");
+	}
+#endif
+	expectEqual("find(only_home)", finder.find("only_home"), home + "/only_home");
+
+	// Misses are remembered until the finder is refreshed
+	expectEqual("find(later)", finder.find("later"), "");
+	touch(second + "/later");
+	expectEqual("find(later) cached", finder.find("later"), "");
+	finder.refresh();
+	expectEqual("find(later) refreshed", finder.find("later"), second + "/later");
+	// invalidateFolderCache() also clears them
+	expectEqual("find(later2)", finder.find("later2"), "");
+	touch(first + "/later2");
+	sago::invalidateFolderCache();
+	expectEqual("find(later2) invalidated", finder.find("later2"), first + "/later2");
+
+	// A negative cache of one only remembers the latest miss
+	sago::FileFinder small(sago::SearchPath::Data, 1);
+	small.find("a");
+	small.find("b");
+	touch(home + "/a");
+	touch(home + "/b");
+	expectEqual("find(a) evicted", small.find("a"), home + "/a");
+	expectEqual("find(b) remembered", small.find("b"), "");
+#endif
+	return 0;
+}
@@ -0,0 +1,38 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <string>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+static void writeUserDirs(const std::string& configHome, const std::string& documents) {
+	writeFile(configHome + "/user-dirs.dirs", "XDG_DOCUMENTS_DIR=\"" + documents + "\"\n");
+}
+
+static void expectDocuments(const std::string& expected) {
+	expectEqual("sago::getDocumentsFolder()", sago::getDocumentsFolder(), expected);
+}
+#endif
+
+int main() {
+#if !defined(_WIN32) && !defined(__APPLE__)
+	TempFolder root("folder_cache");
+	const std::string& configHome = root.path();
+	FakeEnvironment env;
+	env.set(sago::Environment::Home, configHome);
+	env.set(sago::Environment::XdgConfigHome, configHome);
+	writeUserDirs(configHome, "/first");
+	unsigned long long generation = sago::getFolderCacheGeneration();
+	sago::invalidateFolderCache();
+	if (sago::getFolderCacheGeneration() != generation + 1) {
+		fail("invalidateFolderCache() did not bump the generation");
+	}
+	expectDocuments("/first");
+	// If the file was read again the new value would show up
+	writeUserDirs(configHome, "/second");
+	for (int i = 0; i < 10000; ++i) {
+		expectDocuments("/first");
+	}
+	sago::invalidateFolderCache();
+	expectDocuments("/second");
+#endif
+	return 0;
+}
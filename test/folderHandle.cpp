@@ -0,0 +1,71 @@
+#include "tester.hpp"
+#include "../sago/folder_handle.h"
+#include "../sago/platform_folders.h"
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+int main() {
+#ifndef _WIN32
+	sago::FolderHandle empty;
+	if (empty.valid() || empty.fd() != -1 || !empty.path().empty()) {
+		fail("A default constructed handle is valid");
+	}
+	TempFolder root("handle");
+	const std::string home = root.makeFolder("home");
+	root.makeFolder("home/Documents");
+	FakeEnvironment env;
+	env.set(sago::Environment::Home, home);
+	env.set(sago::Environment::XdgConfigHome, root.path() + "/no_user_dirs");
+
+	bool thrown = false;
+	try {
+		sago::getFolderHandle(sago::BaseDir::Config);
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	if (!thrown) {
+		fail("A missing folder was opened");
+	}
+	sago::FolderHandle config = sago::getFolderHandle(sago::BaseDir::Config, true);
+	if (!config.valid() || config.path() != root.path() + "/no_user_dirs") {
+		fail("Unexpected config handle \"" + config.path() + "\"");
+	}
+	// Files are opened relative to the handle
+	int fd = openat(config.fd(), "settings.ini", O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+	if (fd < 0) {
+		fail("openat() relative to the handle failed");
+	}
+	close(fd);
+	struct stat st;
+	if (stat((config.path() + "/settings.ini").c_str(), &st) != 0) {
+		fail("The file was not created in the config folder");
+	}
+	if (sago::getFolderHandle(sago::BaseDir::Config).fd() != config.fd()) {
+		fail("The handle was not cached");
+	}
+
+	sago::FolderHandle documents = sago::getFolderHandle(sago::Folder::Documents);
+	if (documents.path() != home + "/Documents" || fstatat(documents.fd(), ".", &st, 0) != 0 || !S_ISDIR(st.st_mode)) {
+		fail("Unexpected Documents handle");
+	}
+
+	// After a refresh the folder is opened again. The old handle still works.
+	sago::refreshFolderHandles();
+	sago::FolderHandle reopened = sago::getFolderHandle(sago::BaseDir::Config);
+	if (reopened.fd() == config.fd() || fstatat(config.fd(), "settings.ini", &st, 0) != 0) {
+		fail("refreshFolderHandles() did not reopen the folder or closed the old one");
+	}
+	sago::invalidateFolderCache();
+	if (sago::getFolderHandle(sago::BaseDir::Config).fd() == reopened.fd()) {
+		fail("invalidateFolderCache() did not drop the cached handles");
+	}
+#endif
+	return 0;
+}
@@ -0,0 +1,134 @@
+#include "tester.hpp"
+#include "../sago/folder_warmup.h"
+#include "../sago/platform_folders.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+// Stands in for a name service that takes a while to answer
+static std::atomic<bool> entered(false);
+static std::atomic<bool> released(false);
+static std::atomic<int> calls(0);
+
+static bool slowPasswd(unsigned long uid, std::string& home, std::error_code& ec) {
+	calls++;
+	entered = true;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (!released && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	if (uid != 4242) {
+		ec = std::make_error_code(std::errc::no_such_file_or_directory);
+		return false;
+	}
+	home = "/home/slow";
+	return true;
+}
+
+static void waitUntil(const std::atomic<bool>& flag, const char* what) {
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (!flag) {
+		if (std::chrono::steady_clock::now() > deadline) {
+			fail(std::string("Timed out waiting for ") + what);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+static void testSlowPasswd() {
+	FakeEnvironment env;
+	env.set(sago::Environment::XdgDataHome, "/data");
+	sago::setPasswdProvider(slowPasswd);
+
+	sago::FolderWarmup warmup = sago::startFolderWarmup();
+	waitUntil(entered, "the warm-up to call the passwd provider");
+	if (warmup.ready() || warmup.stage() != sago::WarmupStage::Pending) {
+		fail("The warm-up reported progress while the passwd lookup was blocked");
+	}
+	if (warmup.waitFor(std::chrono::milliseconds(1))) {
+		fail("waitFor() returned true while the passwd lookup was blocked");
+	}
+	// Does not need the home folder, so it must not wait
+	if (sago::getDataHome() != "/data") {
+		fail("getDataHome() did not return XDG_DATA_HOME");
+	}
+
+	std::atomic<bool> documentsDone(false);
+	std::string documents;
+	std::thread reader([&]() {
+		documents = sago::getDocumentsFolder();
+		documentsDone = true;
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	if (documentsDone) {
+		fail("getDocumentsFolder() returned before the home folder was known");
+	}
+	released = true;
+	reader.join();
+	if (documents != "/home/slow/Documents") {
+		fail("getDocumentsFolder() returned \"" + documents + "\"");
+	}
+
+	warmup.wait();
+	if (!warmup.ready() || warmup.stage() != sago::WarmupStage::Folders) {
+		fail("The warm-up did not finish");
+	}
+	if (calls != 1) {
+		fail("The passwd provider was called " + std::to_string(calls.load()) + " times");
+	}
+	// Copies share the state
+	sago::FolderWarmup copy = warmup;
+	if (!copy.ready()) {
+		fail("A copy of a finished warm-up is not ready");
+	}
+}
+
+static void testFailure() {
+	FakeEnvironment env;
+	env.setUid(4343);
+	sago::setPasswdProvider(slowPasswd);
+	sago::FolderWarmup warmup = sago::startFolderWarmup();
+	std::error_code ec;
+	warmup.wait(ec);
+	if (ec != std::errc::no_such_file_or_directory) {
+		fail("wait(ec) did not report the passwd error: " + ec.message());
+	}
+	if (warmup.stage() != sago::WarmupStage::Pending) {
+		fail("A failed warm-up advanced past Pending");
+	}
+	try {
+		warmup.wait();
+		fail("wait() did not throw");
+	}
+	catch (const std::system_error& e) {
+		if (e.code() != std::errc::no_such_file_or_directory) {
+			fail(std::string("wait() threw the wrong code: ") + e.what());
+		}
+	}
+}
+#endif
+
+int main() {
+	sago::FolderWarmup none;
+	if (!none.ready() || none.stage() != sago::WarmupStage::Folders) {
+		fail("A default constructed warm-up is not ready");
+	}
+	std::error_code ec;
+	none.wait(ec);
+	if (ec) {
+		fail("A default constructed warm-up reported " + ec.message());
+	}
+#if !defined(_WIN32) && !defined(__APPLE__)
+	testSlowPasswd();
+	testFailure();
+	sago::setPasswdProvider(sago::PasswdProvider());
+#endif
+	// The real thing
+	sago::FolderWarmup warmup = sago::startFolderWarmup();
+	warmup.wait();
+	run_test(sago::getDocumentsFolder());
+	return 0;
+}
@@ -0,0 +1,48 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void expectEqual(const char* name, const std::string& actual, const std::string& expected) {
+	if (actual != expected) {
+		std::cerr << name << " was \"" << actual << "\" expected \"" << expected << "\"\n";
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+static void expectEqual(const char* name, const std::vector<std::string>& actual, const std::vector<std::string>& expected) {
+	if (actual != expected) {
+		std::cerr << name << " has " << actual.size() << " entries expected " << expected.size() << "\n";
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+int main() {
+	sago::AllFolders folders;
+	// Stale values must be replaced
+	folders.additionalDataDirectories.push_back("stale");
+	sago::getAllFolders(folders);
+	run_test(folders.configHome);
+	expectEqual("dataHome", folders.dataHome, sago::getDataHome());
+	expectEqual("configHome", folders.configHome, sago::getConfigHome());
+	expectEqual("cacheDir", folders.cacheDir, sago::getCacheDir());
+	expectEqual("stateDir", folders.stateDir, sago::getStateDir());
+	expectEqual("saveGamesFolder1", folders.saveGamesFolder1, sago::getSaveGamesFolder1());
+	expectEqual("saveGamesFolder2", folders.saveGamesFolder2, sago::getSaveGamesFolder2());
+	expectEqual("Desktop", folders.folder(sago::Folder::Desktop), sago::getDesktopFolder());
+	expectEqual("Documents", folders.folder(sago::Folder::Documents), sago::getDocumentsFolder());
+	expectEqual("Download", folders.folder(sago::Folder::Download), sago::getDownloadFolder());
+	expectEqual("Music", folders.folder(sago::Folder::Music), sago::getMusicFolder());
+	expectEqual("Pictures", folders.folder(sago::Folder::Pictures), sago::getPicturesFolder());
+	expectEqual("Public", folders.folder(sago::Folder::Public), sago::getPublicFolder());
+	expectEqual("Videos", folders.folder(sago::Folder::Videos), sago::getVideoFolder());
+	std::vector<std::string> dataDirs;
+	sago::appendAdditionalDataDirectories(dataDirs);
+	expectEqual("additionalDataDirectories", folders.additionalDataDirectories, dataDirs);
+	std::vector<std::string> configDirs;
+	sago::appendAdditionalConfigDirectories(configDirs);
+	expectEqual("additionalConfigDirectories", folders.additionalConfigDirectories, configDirs);
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifndef _WIN32
+#include <pwd.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Every uid the passwd provider was asked for
+static std::vector<unsigned long> lookups;
+
+static bool countingProvider(unsigned long uid, std::string& home, std::error_code&) {
+	lookups.push_back(uid);
+	home = "/home/uid" + std::to_string(uid);
+	return true;
+}
+
+static void expectLookups(const std::string& name, std::size_t count, unsigned long lastUid) {
+	if (lookups.size() != count) {
+		fail(name + ": expected " + std::to_string(count) + " passwd lookups, got " + std::to_string(lookups.size()));
+	}
+	if (count > 0 && lookups.back() != lastUid) {
+		fail(name + ": looked up uid " + std::to_string(lookups.back()) + " expected " + std::to_string(lastUid));
+	}
+}
+#endif
+
+int main() {
+#ifndef _WIN32
+	std::string first = sago::internal::getHome();
+	run_test(first);
+	expectEqual("A second getHome()", sago::internal::getHome(), first);
+
+	sago::setPasswdProvider(countingProvider);
+	{
+		FakeEnvironment env;
+		// HOME is used by other users than root without a lookup
+		env.set(sago::Environment::Home, "/changed/home");
+		expectEqual("getHome() with HOME", sago::internal::getHome(), "/changed/home");
+		expectLookups("HOME set", 0, 0);
+
+		// Without HOME the passwd entry is looked up once
+		env.unset(sago::Environment::Home);
+		expectEqual("getHome()", sago::internal::getHome(), "/home/uid4242");
+		expectEqual("A repeated getHome()", sago::internal::getHome(), "/home/uid4242");
+		expectEqual("The folders", sago::getDataHome(), "/home/uid4242/.local/share");
+		expectLookups("Repeated calls", 1, 4242);
+
+		// A changed uid is looked up again
+		env.setUid(5000);
+		expectEqual("getHome() after the uid changed", sago::internal::getHome(), "/home/uid5000");
+		sago::internal::getHome();
+		expectLookups("Changed uid", 2, 5000);
+
+		// root ignores HOME
+		env.setUid(0).set(sago::Environment::Home, "/changed/home");
+		expectEqual("getHome() as root", sago::internal::getHome(), "/home/uid0");
+		expectLookups("root", 3, 0);
+
+		if (geteuid() == 0) {
+			// The entry is also keyed on the effective uid. Dropping privileges must not reuse the entry of root.
+			pid_t child = fork();
+			if (child < 0) {
+				fail("fork() failed");
+			}
+			if (child == 0) {
+				if (seteuid(65534) != 0) {
+					fail("seteuid() failed");
+				}
+				sago::internal::getHome();
+				expectLookups("Changed effective uid", 4, 0);
+				_exit(0);
+			}
+			int status = 0;
+			waitpid(child, &status, 0);
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				fail("The effective uid check failed");
+			}
+		}
+	}
+	sago::setPasswdProvider(sago::PasswdProvider());
+	run_test(sago::internal::getHome());
+
+	struct passwd* nobody = getpwuid(65534);
+	if (getuid() == 0 && nobody && nobody->pw_dir) {
+		// A process that drops root finds the home of the new user without invalidateFolderCache()
+		const std::string nobodyHome = nobody->pw_dir;
+		const std::string rootHome = getpwuid(0)->pw_dir;
+		pid_t child = fork();
+		if (child < 0) {
+			fail("fork() failed");
+		}
+		if (child == 0) {
+			unsetenv("HOME");
+			sago::invalidateFolderCache();
+			expectEqual("getHome() as root", sago::internal::getHome(), rootHome);
+			if (setuid(65534) != 0) {
+				fail("setuid() failed");
+			}
+			expectEqual("getHome() after setuid()", sago::internal::getHome(), nobodyHome);
+			_exit(0);
+		}
+		int status = 0;
+		waitpid(child, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			fail("getHome() did not follow setuid()");
+		}
+	}
+#endif
+	return 0;
+}
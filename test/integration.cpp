@@ -29,6 +29,7 @@ int main() {
 	run_test(p.getVideoFolder());
 	run_test(p.getDownloadFolder1());
 	run_test(p.getSaveGamesFolder1());
+	run_test(p.getFolder(sago::Folder::Templates));
 	// Test vector function
 	std::vector<std::string> extraData;
 	sago::appendAdditionalDataDirectories(extraData);
@@ -17,6 +17,26 @@ int main() {
 		std::cerr << "sago::internal::appendExtraFoldersTokenizer did not return \"/three\"\n";
 		std::exit(EXIT_FAILURE);
 	}
+	extraData.clear();
+	sago::internal::appendExtraFoldersTokenizer("", "/a/::/b:/a/:/a//:", extraData);
+	if (extraData.size() != 4) {
+		std::cerr << "sago::internal::appendExtraFoldersTokenizer should keep duplicates by default\n";
+		std::exit(EXIT_FAILURE);
+	}
+	extraData.clear();
+	extraData.push_back("/b");
+	sago::internal::appendExtraFoldersTokenizer("", "/a/::/b:/a/:/a//:/:/c", extraData, sago::FolderListNormalizeTrailingSlash | sago::FolderListRemoveDuplicates);
+	const char* expected[] = { "/b", "/a", "/", "/c" };
+	if (extraData.size() != 4) {
+		std::cerr << "sago::internal::appendExtraFoldersTokenizer returned " << extraData.size() << " folders, expected 4\n";
+		std::exit(EXIT_FAILURE);
+	}
+	for (std::size_t i = 0; i < 4; ++i) {
+		if (extraData[i] != expected[i]) {
+			std::cerr << "sago::internal::appendExtraFoldersTokenizer returned \"" << extraData[i] << "\" expected \"" << expected[i] << "\"\n";
+			std::exit(EXIT_FAILURE);
+		}
+	}
 	#endif
 	return 0;
 }
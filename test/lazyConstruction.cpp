@@ -0,0 +1,57 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main() {
+	{
+		sago::PlatformFolders pf;
+		run_test(pf.getDocumentsFolder());
+	}
+#if !defined(_WIN32) && !defined(__APPLE__)
+	TempFolder root("lazy");
+	const std::string& configHome = root.path();
+	FakeEnvironment env;
+	env.set(sago::Environment::Home, configHome);
+
+	// Nothing is resolved yet, so an invalid XDG_CONFIG_HOME is only noticed by the getters that need it
+	env.set(sago::Environment::XdgConfigHome, "relative/path");
+	{
+		sago::PlatformFolders pf;
+		pf.getSaveGamesFolder1();
+		bool thrown = false;
+		try {
+			pf.getDocumentsFolder();
+		}
+		catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		if (!thrown) {
+			fail("getDocumentsFolder() accepted a relative XDG_CONFIG_HOME");
+		}
+		// A failed resolve is retried
+		env.set(sago::Environment::XdgConfigHome, configHome);
+		expectEqual("getDocumentsFolder() after the retry", pf.getDocumentsFolder(), configHome + "/Documents");
+	}
+
+	// The file is written after construction. It must still be picked up.
+	sago::PlatformFolders pf;
+	writeFile(configHome + "/user-dirs.dirs", "XDG_DOCUMENTS_DIR=\"/lazy\"\n");
+	std::string results[8];
+	std::vector<std::thread> threads;
+	for (std::size_t i = 0; i < 8; ++i) {
+		threads.push_back(std::thread([&pf, &results, i]() {
+			results[i] = pf.getDocumentsFolder();
+		}));
+	}
+	for (std::size_t i = 0; i < threads.size(); ++i) {
+		threads[i].join();
+	}
+	for (std::size_t i = 0; i < 8; ++i) {
+		expectEqual("Thread " + std::to_string(i), results[i], "/lazy");
+	}
+#endif
+	return 0;
+}
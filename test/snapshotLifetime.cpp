@@ -0,0 +1,88 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Readers copy folders out of snapshots while the main thread keeps replacing them with changed ones.
+// The environment and the passwd home are replaced as well, as the uid changes every round,
+// and so is the diagnostic sink the readers report to.
+// A snapshot freed while a reader still uses it is reported by -DPLATFORMFOLDERS_ENABLE_ASAN=ON.
+// -DPLATFORMFOLDERS_ENABLE_TSAN=ON checks the same readers for races.
+#if !defined(_WIN32) && !defined(__APPLE__)
+static bool expected(const std::string& value) {
+	return value == "/first" || value == "/second";
+}
+
+static bool homeProvider(unsigned long uid, std::string& home, std::error_code&) {
+	home = "/home/uid" + std::to_string(uid);
+	return true;
+}
+
+static bool expectedHome(const std::string& value) {
+	return value == "/home/uid4242" || value == "/home/uid4243";
+}
+#endif
+
+int main() {
+#if !defined(_WIN32) && !defined(__APPLE__)
+	TempFolder root("snapshot_lifetime");
+	const std::string& configHome = root.path();
+	FakeEnvironment env;
+	// Without HOME the home folder comes from the passwd provider
+	env.set(sago::Environment::XdgConfigHome, configHome);
+	sago::setPasswdProvider(homeProvider);
+	writeFile(configHome + "/user-dirs.dirs", "XDG_DOCUMENTS_DIR=\"/first\"\n");
+	sago::PlatformFolders shared;
+	// Silent until the main thread installs its first sink
+	sago::setDiagnosticSink(sago::DiagnosticSink());
+	std::atomic<bool> done(false);
+	std::atomic<int> failures(0);
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; ++t) {
+		readers.push_back(std::thread([&]() {
+			char buffer[256];
+			while (!done.load()) {
+				std::error_code ec;
+				sago::getFolder(sago::Folder::Documents, buffer, sizeof(buffer), ec);
+				if (!expected(sago::getDocumentsFolder()) || !expected(sago::get<sago::Folder::Documents>()) ||
+						!expected(shared.getDocumentsFolder()) || ec || !expected(buffer)) {
+					++failures;
+				}
+				std::shared_ptr<const sago::Environment> current = sago::getEnvironment();
+				const char* value = current->get(sago::Environment::XdgConfigHome);
+				if (!value || value != configHome || !expectedHome(sago::internal::getHome())) {
+					++failures;
+				}
+				sago::internal::reportDiagnostic(sago::Diagnostic::InvalidUserDirsLine, "Reader %s", "diagnostic");
+			}
+		}));
+	}
+	for (int i = 0; i < 500; ++i) {
+		// Every refresh finds a changed file, so every snapshot is replaced
+		writeFile(configHome + "/user-dirs.dirs", i % 2 ? "XDG_DOCUMENTS_DIR=\"/first\"\n" : "XDG_DOCUMENTS_DIR=\"/second\"\n");
+		env.setUid(i % 2 ? 4242 : 4243);
+		// The captured string is freed with the sink
+		std::string round = std::to_string(i);
+		sago::setDiagnosticSink([round, &failures](sago::Diagnostic, const char* message) {
+			if (round.empty() || std::string(message) != "Reader diagnostic") {
+				++failures;
+			}
+		});
+		sago::internal::refreshFolderCache();
+		shared.refresh();
+	}
+	done = true;
+	for (std::thread& t : readers) {
+		t.join();
+	}
+	sago::setPasswdProvider(sago::PasswdProvider());
+	sago::resetDiagnosticSink();
+	if (failures.load() != 0) {
+		fail("Readers saw " + std::to_string(failures.load()) + " unexpected values while the snapshots were replaced");
+	}
+#endif
+	return 0;
+}
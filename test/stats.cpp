@@ -0,0 +1,58 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <string>
+
+static unsigned long long bucketSum(const sago::LatencyHistogram& histogram) {
+	unsigned long long sum = 0;
+	for (std::size_t i = 0; i < sago::LatencyHistogram::bucketCount; ++i) {
+		sum += histogram.buckets[i];
+	}
+	return sum;
+}
+
+int main() {
+	sago::resetStats();
+	for (int i = 0; i < 11; ++i) {
+		sago::getDocumentsFolder();
+	}
+	{
+		sago::PlatformFolders pf;
+		pf.getMusicFolder();
+	}
+#ifndef _WIN32
+	sago::internal::getHome();
+#endif
+	sago::Stats stats;
+	sago::getStats(stats);
+	if (!sago::statsEnabled()) {
+		// Compiled out. Everything must stay zero.
+		if (stats.lookups != 0 || stats.folderCacheHits != 0 || stats.resolve.count != 0 || stats.getHome.count != 0) {
+			fail("Counters changed although stats are disabled");
+		}
+		return 0;
+	}
+	if (stats.lookups < 11 || stats.folderCacheHits < 10 || stats.folderCacheMisses < 1) {
+		fail("Unexpected lookup counters: lookups=" + std::to_string(stats.lookups) + " hits=" + std::to_string(stats.folderCacheHits)
+			+ " misses=" + std::to_string(stats.folderCacheMisses));
+	}
+	// The process-wide cache and the local object both resolved once
+	if (stats.resolve.count != 2 || bucketSum(stats.resolve) != stats.resolve.count) {
+		fail("Expected 2 resolves, got " + std::to_string(stats.resolve.count));
+	}
+#if !defined(_WIN32) && !defined(__APPLE__)
+	if (stats.userDirsReads != 2) {
+		fail("Expected user-dirs.dirs to be read twice, got " + std::to_string(stats.userDirsReads));
+	}
+#endif
+#ifndef _WIN32
+	if (stats.getHome.count == 0 || bucketSum(stats.getHome) != stats.getHome.count) {
+		fail("getHome() was not timed");
+	}
+#endif
+	sago::resetStats();
+	sago::getStats(stats);
+	if (stats.lookups != 0 || stats.resolve.count != 0) {
+		fail("resetStats() did not clear the counters");
+	}
+	return 0;
+}
@@ -1,11 +1,22 @@
 #include "tester.hpp"
 
+#include <cerrno>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#ifndef _WIN32
+#include <ftw.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 // This should be passed either be char* or std::string for this to work
 static void test_internal(const std::string& data) {
 	try {
@@ -38,3 +49,103 @@ void run_test(const std::vector<std::string>& vec) {
 		test_internal(elem);
 	}
 }
+
+void fail(const std::string& message) {
+	std::cerr << message << std::endl;
+	std::exit(EXIT_FAILURE);
+}
+
+void expectEqual(const std::string& name, const std::string& actual, const std::string& expected) {
+	if (actual != expected) {
+		fail(name + " returned \"" + actual + "\" expected \"" + expected + "\"");
+	}
+}
+
+#ifndef _WIN32
+void writeFile(const std::string& path, const std::string& contents) {
+	std::string tmp = path + ".tmp";
+	std::ofstream out(tmp.c_str(), std::ios::binary);
+	out << contents;
+	out.close();
+	if (!out || std::rename(tmp.c_str(), path.c_str()) != 0) {
+		fail("Failed to write \"" + path + "\"");
+	}
+}
+
+void overwriteFile(const std::string& path, const std::string& contents) {
+	std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+	out << contents;
+	out.close();
+	if (!out) {
+		fail("Failed to write \"" + path + "\"");
+	}
+}
+
+TempFolder::TempFolder(const std::string& name) {
+	std::string pattern = "/tmp/sago_" + name + "_XXXXXX";
+	std::vector<char> buffer(pattern.begin(), pattern.end());
+	buffer.push_back('\0');
+	if (!mkdtemp(buffer.data())) {
+		fail("Failed to create a temporary folder: " + std::string(std::strerror(errno)));
+	}
+	root = buffer.data();
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+	return remove(path);
+}
+
+TempFolder::~TempFolder() {
+	// Depth first without following symlinks
+	nftw(root.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+std::string TempFolder::makeFolder(const std::string& relative) const {
+	std::string path = root;
+	std::size_t start = 0;
+	while (start < relative.size()) {
+		std::size_t end = relative.find('/', start);
+		if (end == std::string::npos) {
+			end = relative.size();
+		}
+		path += "/" + relative.substr(start, end - start);
+		if (mkdir(path.c_str(), 0700) != 0 && errno != EEXIST) {
+			fail("Failed to create \"" + path + "\"");
+		}
+		start = end + 1;
+	}
+	return path;
+}
+
+FakeEnvironment::FakeEnvironment() {
+	env.setUid(4242);
+	apply();
+}
+
+FakeEnvironment::~FakeEnvironment() {
+	sago::setEnvironmentProvider(sago::EnvironmentProvider());
+}
+
+FakeEnvironment& FakeEnvironment::set(sago::Environment::Variable variable, const std::string& value) {
+	env.set(variable, value);
+	apply();
+	return *this;
+}
+
+FakeEnvironment& FakeEnvironment::unset(sago::Environment::Variable variable) {
+	env.unset(variable);
+	apply();
+	return *this;
+}
+
+FakeEnvironment& FakeEnvironment::setUid(unsigned long uid) {
+	env.setUid(uid);
+	apply();
+	return *this;
+}
+
+void FakeEnvironment::apply() {
+	sago::Environment copy = env;
+	sago::setEnvironmentProvider([copy]() { return copy; });
+}
+#endif
@@ -1,6 +1,7 @@
 #ifndef SAGO_TEST_HPP
 #define SAGO_TEST_HPP
 
+#include "../sago/platform_folders.h"
 #include <string>
 #include <vector>
 
@@ -10,4 +11,54 @@ void run_test(const std::string&);
 // A special overload for the two funcs that take a vector
 void run_test(const std::vector<std::string>&);
 
+// Prints the message and exits with a failure
+[[noreturn]] void fail(const std::string& message);
+
+// Fails if actual is not expected. name says what was checked.
+void expectEqual(const std::string& name, const std::string& actual, const std::string& expected);
+
+#ifndef _WIN32
+// Replaces the file like an editor would, by writing a temporary file and renaming it over path
+void writeFile(const std::string& path, const std::string& contents);
+
+// Writes the file in place, keeping the inode
+void overwriteFile(const std::string& path, const std::string& contents);
+
+/**
+ * A folder under /tmp that is removed with everything in it when the object is destroyed.
+ */
+class TempFolder {
+public:
+	explicit TempFolder(const std::string& name);
+	~TempFolder();
+	const std::string& path() const {
+		return root;
+	}
+	// Creates path()/relative and its parents. Returns the full path.
+	std::string makeFolder(const std::string& relative) const;
+private:
+	TempFolder(const TempFolder&) = delete;
+	TempFolder& operator=(const TempFolder&) = delete;
+	std::string root;
+};
+
+/**
+ * Resolves the folders from a fake environment with uid 4242 and no variables set while the object exists.
+ * Every change is applied right away. The process environment is used again when the object is destroyed.
+ */
+class FakeEnvironment {
+public:
+	FakeEnvironment();
+	~FakeEnvironment();
+	FakeEnvironment& set(sago::Environment::Variable variable, const std::string& value);
+	FakeEnvironment& unset(sago::Environment::Variable variable);
+	FakeEnvironment& setUid(unsigned long uid);
+private:
+	FakeEnvironment(const FakeEnvironment&) = delete;
+	FakeEnvironment& operator=(const FakeEnvironment&) = delete;
+	void apply();
+	sago::Environment env;
+};
+#endif
+
 #endif
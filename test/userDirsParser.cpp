@@ -0,0 +1,66 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+struct Entry {
+	std::string value;
+	bool relativeToHome;
+};
+
+static std::map<std::string, Entry> parse(const std::string& content) {
+	std::map<std::string, Entry> entries;
+	sago::internal::parseUserDirs("test", content.data(), content.size(), [&](const char* key, std::size_t keyLength, std::string& value, bool relativeToHome) {
+		Entry entry;
+		entry.value = value;
+		entry.relativeToHome = relativeToHome;
+		entries[std::string(key, keyLength)] = entry;
+	});
+	return entries;
+}
+
+static void expect(const std::string& content, const std::string& key, const std::string& value, bool relativeToHome) {
+	std::map<std::string, Entry> entries = parse(content);
+	std::map<std::string, Entry>::const_iterator itr = entries.find(key);
+	if (itr == entries.end()) {
+		std::cerr << "No " << key << " parsed from: " << content << "\n";
+		std::exit(EXIT_FAILURE);
+	}
+	if (itr->second.value != value || itr->second.relativeToHome != relativeToHome) {
+		std::cerr << "Parsing: " << content << " gave \"" << itr->second.value << "\" relativeToHome=" << itr->second.relativeToHome << "\n";
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+static void expectNothing(const std::string& content) {
+	if (!parse(content).empty()) {
+		std::cerr << "Expected nothing to be parsed from: " << content << "\n";
+		std::exit(EXIT_FAILURE);
+	}
+}
+#endif
+
+int main() {
+#if !defined(_WIN32) && !defined(__APPLE__)
+	expect("XDG_DESKTOP_DIR=\"$HOME/Desktop\"\n", "XDG_DESKTOP_DIR", "/Desktop", true);
+	expect("XDG_MUSIC_DIR=\"/mnt/music\"", "XDG_MUSIC_DIR", "/mnt/music", false);
+	expect("  XDG_MUSIC_DIR=\"${HOME}/My Music\"  # comment\r\n", "XDG_MUSIC_DIR", "/My Music", true);
+	expect("XDG_MUSIC_DIR=\"/a \\\"quoted\\\" \\$HOME \\\\ dir\"", "XDG_MUSIC_DIR", "/a \"quoted\" $HOME \\ dir", false);
+	expect("XDG_MUSIC_DIR='/single $HOME \\ quoted'", "XDG_MUSIC_DIR", "/single $HOME \\ quoted", false);
+	expect("XDG_MUSIC_DIR=/un\\ quoted", "XDG_MUSIC_DIR", "/un quoted", false);
+	expect("XDG_MUSIC_DIR=\"$HOMEDIR/x\"", "XDG_MUSIC_DIR", "$HOMEDIR/x", false);
+	expect("XDG_MUSIC_DIR=\"/con\"'cat'", "XDG_MUSIC_DIR", "/concat", false);
+	expect("# XDG_VIDEOS_DIR=\"/no\"\nXDG_VIDEOS_DIR=\"/yes\"", "XDG_VIDEOS_DIR", "/yes", false);
+	expect("XDG_VIDEOS_DIR=\"/broken\nXDG_MUSIC_DIR=\"/fine\"", "XDG_MUSIC_DIR", "/fine", false);
+	expectNothing("# XDG_DESKTOP_DIR=\"/commented\"");
+	expectNothing("OTHER_VARIABLE=\"/x\"\nXDG_CONFIG_HOME=\"/x\"");
+	expectNothing("XDG_DESKTOP_DIR \"/missing equals\"");
+	expectNothing("XDG_DESKTOP_DIR=\"/unterminated");
+	expectNothing("XDG_DESKTOP_DIR='/unterminated");
+	expectNothing("");
+#endif
+	return 0;
+}
@@ -0,0 +1,67 @@
+#include "tester.hpp"
+#include "../sago/platform_folders.h"
+#include "../sago/user_dirs_watcher.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+#ifdef __linux__
+static void writeUserDirs(const std::string& configHome, const std::string& documents) {
+	// Written and renamed like most editors do
+	writeFile(configHome + "/user-dirs.dirs", "XDG_DOCUMENTS_DIR=\"" + documents + "\"\n");
+}
+#endif
+
+int main() {
+#ifdef __linux__
+	TempFolder root("watcher");
+	const std::string configHome = root.makeFolder("config");
+	FakeEnvironment env;
+	env.set(sago::Environment::Home, root.path());
+	env.set(sago::Environment::XdgConfigHome, configHome);
+	writeUserDirs(configHome, "/before");
+	expectEqual("getDocumentsFolder()", sago::getDocumentsFolder(), "/before");
+	std::mutex mutex;
+	std::condition_variable changed;
+	int notifications = 0;
+	{
+		sago::UserDirsWatcher watcher;
+		watcher.subscribe([&]() {
+			std::lock_guard<std::mutex> lock(mutex);
+			++notifications;
+			changed.notify_all();
+		});
+		writeUserDirs(configHome, "/after");
+		std::unique_lock<std::mutex> lock(mutex);
+		// The timeout only guards against hanging the test suite
+		if (!changed.wait_for(lock, std::chrono::seconds(10), [&]() { return notifications > 0; })) {
+			fail("The watcher did not report the change");
+		}
+	}
+	expectEqual("getDocumentsFolder() after the change", sago::getDocumentsFolder(), "/after");
+
+	{
+		// The config folder does not exist yet. Its parents are watched until it is created.
+		const std::string missingHome = root.path() + "/missing/config";
+		env.set(sago::Environment::XdgConfigHome, missingHome);
+		notifications = 0;
+		sago::UserDirsWatcher watcher;
+		watcher.subscribe([&]() {
+			std::lock_guard<std::mutex> lock(mutex);
+			++notifications;
+			changed.notify_all();
+		});
+		// Created right after each other. The watcher must not lose a folder that appears while it moves its watch.
+		root.makeFolder("missing");
+		root.makeFolder("missing/config");
+		writeUserDirs(missingHome, "/created");
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!changed.wait_for(lock, std::chrono::seconds(10), [&]() { return notifications > 0; })) {
+			fail("The watcher did not notice the file in the new config folder");
+		}
+	}
+	expectEqual("getDocumentsFolder() in the new config folder", sago::getDocumentsFolder(), "/created");
+#endif
+	return 0;
+}
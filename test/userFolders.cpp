@@ -0,0 +1,271 @@
+#include "tester.hpp"
+#include "../sago/user_folders.h"
+#include "../sago/platform_folders.h"
+#include <cstdio>
+#include <string>
+#include <system_error>
+
+#ifndef _WIN32
+#include "../sago/internal_posix.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::string firstHome;
+static std::string secondHome;
+static int lookups = 0;
+// Lookups of uid 1234 that fail before it is found
+static int flakyFailures = 1;
+// user-dirs.dirs is only read if the user owns it. As root the files are given to 5000, otherwise the test user is used.
+static const unsigned long firstUid = geteuid() == 0 ? 5000 : geteuid();
+
+static bool fakePasswd(unsigned long uid, std::string& home, std::error_code& ec) {
+	++lookups;
+	if (uid == firstUid) {
+		home = firstHome;
+		return true;
+	}
+	if (uid == 5001) {
+		home = secondHome;
+		return true;
+	}
+	if (uid == 0) {
+		home = "/fake-root";
+		return true;
+	}
+	if (uid == 1234) {
+		if (flakyFailures > 0) {
+			--flakyFailures;
+			ec = std::make_error_code(std::errc::resource_unavailable_try_again);
+			return false;
+		}
+		home = "/home/flaky";
+		return true;
+	}
+	ec = std::make_error_code(std::errc::no_such_file_or_directory);
+	return false;
+}
+
+static bool fakeUserNames(const std::string& userName, unsigned long& uid, std::error_code& ec) {
+	if (userName == "root") {
+		uid = 0;
+		return true;
+	}
+	if (userName == "sago-second-user") {
+		uid = 5001;
+		return true;
+	}
+	ec = std::make_error_code(std::errc::no_such_file_or_directory);
+	return false;
+}
+
+static void giveTo(const std::string& path, unsigned long uid) {
+	if (geteuid() == 0 && lchown(path.c_str(), uid, uid) != 0) {
+		fail("Failed to give \"" + path + "\" to uid " + std::to_string(uid));
+	}
+}
+
+static void writeUserDirs(const std::string& path, const std::string& contents) {
+	writeFile(path, contents);
+	giveTo(path, firstUid);
+}
+#endif
+
+int main() {
+#ifndef _WIN32
+	TempFolder firstFolder("user_folders");
+	TempFolder secondFolder("user_folders");
+	firstHome = firstFolder.path();
+	secondHome = secondFolder.path();
+	// The process environment must not leak into the folders of other users
+	FakeEnvironment env;
+	env.set(sago::Environment::Home, "/not/used");
+	env.set(sago::Environment::XdgDataHome, "/not/used/data");
+	sago::setPasswdProvider(fakePasswd);
+	sago::setUserNameProvider(fakeUserNames);
+
+	sago::UserFolders first(firstUid);
+	if (first.getUid() != firstUid) {
+		fail("getUid() returned " + std::to_string(first.getUid()));
+	}
+	expectEqual("getHome()", first.getHome(), firstHome);
+#ifdef __APPLE__
+	expectEqual("getDataHome()", first.getDataHome(), firstHome + "/Library/Application Support");
+	expectEqual("getCacheDir()", first.getCacheDir(), firstHome + "/Library/Caches");
+	expectEqual("getDocumentsFolder()", first.getDocumentsFolder(), firstHome + "/Documents");
+#else
+	expectEqual("getDataHome()", first.getDataHome(), firstHome + "/.local/share");
+	expectEqual("getConfigHome()", first.getConfigHome(), firstHome + "/.config");
+	expectEqual("getCacheDir()", first.getCacheDir(), firstHome + "/.cache");
+	expectEqual("getStateDir()", first.getStateDir(), firstHome + "/.local/state");
+	expectEqual("getBaseDir(Cache)", first.getBaseDir(sago::BaseDir::Cache), firstHome + "/.cache");
+	expectEqual("getDocumentsFolder()", first.getDocumentsFolder(), firstHome + "/Documents");
+
+	// user-dirs.dirs of that user is read
+	std::string configDir = firstFolder.makeFolder(".config");
+	const std::string userDirs = configDir + "/user-dirs.dirs";
+	writeUserDirs(userDirs, "XDG_MUSIC_DIR=\"$HOME/Tunes\"\n");
+	sago::UserFolders changed(firstUid);
+	expectEqual("getMusicFolder() after writing user-dirs.dirs", changed.getMusicFolder(), firstHome + "/Tunes");
+	// The old object keeps what it had until it is refreshed
+	expectEqual("getMusicFolder() of the old object", first.getMusicFolder(), firstHome + "/Music");
+	first.refresh();
+	expectEqual("getMusicFolder() after refresh()", first.getMusicFolder(), firstHome + "/Tunes");
+	writeUserDirs(userDirs, "XDG_VIDEOS_DIR=\"$HOME/Films\"\nXDG_PICTURES_DIR=\"" + firstHome + "/Photos\"\n");
+	sago::UserFolders changedAgain(firstUid);
+	expectEqual("getMusicFolder() after changing user-dirs.dirs", changedAgain.getMusicFolder(), firstHome + "/Music");
+	expectEqual("getVideoFolder() after changing user-dirs.dirs", changedAgain.getVideoFolder(), firstHome + "/Films");
+	expectEqual("An absolute folder inside the home folder", changedAgain.getPicturesFolder(), firstHome + "/Photos");
+
+	// Values that leave the home folder are ignored
+	writeUserDirs(userDirs, "XDG_MUSIC_DIR=\"/srv/music\"\nXDG_VIDEOS_DIR=\"$HOME/../../etc\"\n"
+		"XDG_PICTURES_DIR=\"" + firstHome + "2/Photos\"\nXDG_DESKTOP_DIR=\"$HOME/Table\"\n");
+	sago::UserFolders escaping(firstUid);
+	expectEqual("An absolute folder outside the home folder", escaping.getMusicFolder(), firstHome + "/Music");
+	expectEqual("A folder with ..", escaping.getVideoFolder(), firstHome + "/Videos");
+	expectEqual("A folder next to the home folder", escaping.getPicturesFolder(), firstHome + "/Pictures");
+	expectEqual("A folder in the home folder next to ignored ones", escaping.getDesktopFolder(), firstHome + "/Table");
+
+	// A file that the user does not control alone is ignored
+	const std::string trusted = "XDG_MUSIC_DIR=\"$HOME/Trusted\"\n";
+	writeUserDirs(userDirs, trusted);
+	if (chmod(userDirs.c_str(), 0664) != 0) {
+		fail("chmod() failed");
+	}
+	expectEqual("A group writable file", sago::UserFolders(firstUid).getMusicFolder(), firstHome + "/Music");
+	if (chmod(userDirs.c_str(), 0644) != 0) {
+		fail("chmod() failed");
+	}
+	expectEqual("The same file after chmod()", sago::UserFolders(firstUid).getMusicFolder(), firstHome + "/Trusted");
+	if (geteuid() == 0) {
+		giveTo(userDirs, 5001);
+		expectEqual("A file owned by another user", sago::UserFolders(firstUid).getMusicFolder(), firstHome + "/Music");
+	}
+
+	// A symbolic link is not followed, even to a file the user owns
+	const std::string target = configDir + "/elsewhere.dirs";
+	writeUserDirs(target, trusted);
+	std::remove(userDirs.c_str());
+	if (symlink(target.c_str(), userDirs.c_str()) != 0) {
+		fail("symlink() failed");
+	}
+	giveTo(userDirs, firstUid);
+	expectEqual("A symbolic link", sago::UserFolders(firstUid).getMusicFolder(), firstHome + "/Music");
+
+	// A FIFO must not block the lookup
+	std::remove(userDirs.c_str());
+	if (mkfifo(userDirs.c_str(), 0600) != 0) {
+		fail("mkfifo() failed");
+	}
+	giveTo(userDirs, firstUid);
+	expectEqual("A FIFO", sago::UserFolders(firstUid).getMusicFolder(), firstHome + "/Music");
+	std::remove(userDirs.c_str());
+
+	// Only the home folder itself decides what is inside. A home folder of "/" trusts no entry.
+	if (!sago::internal::isInsideFolder(firstHome, firstHome + "/Music")) {
+		fail("A folder in the home folder is not inside it");
+	}
+	if (sago::internal::isInsideFolder("/", "/etc/cron.d") || sago::internal::isInsideFolder("//", "/etc/cron.d")) {
+		fail("A home folder of \"/\" trusted an entry");
+	}
+	if (sago::internal::isInsideFolder("", "/etc/cron.d")) {
+		fail("An empty home folder trusted an entry");
+	}
+#endif
+	// Neither a cache hit nor a changed user-dirs.dirs looks up the home folder again
+	sago::UserFolders again(firstUid);
+	if (lookups != 1) {
+		fail("The passwd provider was called " + std::to_string(lookups) + " times for one user");
+	}
+
+	// Bounded
+	sago::setUserFoldersCacheLimit(1);
+	sago::UserFolders second(5001);
+	expectEqual("getHome() of the second user", second.getHome(), secondHome);
+	if (sago::getUserFoldersCacheSize() != 1) {
+		fail("The cache holds " + std::to_string(sago::getUserFoldersCacheSize()) + " users with a limit of 1");
+	}
+	// Evicted users keep their folders
+	expectEqual("getHome() of an evicted user", again.getHome(), firstHome);
+	sago::UserFolders evicted(firstUid);
+	if (lookups != 3) {
+		fail("An evicted user was not looked up again");
+	}
+	sago::setUserFoldersCacheLimit(256);
+
+	// Unknown users
+	std::error_code ec;
+	sago::UserFolders unknown(6000, ec);
+	if (ec != std::errc::no_such_file_or_directory) {
+		fail("An unknown uid did not fail: " + ec.message());
+	}
+	if (!unknown.getHome().empty() || !unknown.getDocumentsFolder().empty()) {
+		fail("An unknown uid returned folders");
+	}
+	try {
+		sago::UserFolders throwing(6000);
+		fail("An unknown uid did not throw");
+	}
+	catch (const std::system_error& e) {
+		if (e.code() != std::errc::no_such_file_or_directory) {
+			fail(std::string("An unknown uid threw ") + e.what());
+		}
+	}
+	sago::UserFolders noName("sago-no-such-user", ec);
+	if (!ec) {
+		fail("An unknown user name did not fail");
+	}
+	if (noName.getUid() != sago::UserFolders::unknownUid) {
+		fail("An unknown user name has uid " + std::to_string(noName.getUid()));
+	}
+	noName.refresh(ec);
+	if (!ec || !noName.getHome().empty()) {
+		fail("refresh() of an unknown user name found folders");
+	}
+
+	// A user that failed once keeps its uid, so refresh() does not resolve the folders of root
+	sago::UserFolders flaky(1234, ec);
+	if (ec != std::errc::resource_unavailable_try_again) {
+		fail("The failing lookup of uid 1234 did not fail: " + ec.message());
+	}
+	if (flaky.getUid() != 1234) {
+		fail("A failed uid 1234 has uid " + std::to_string(flaky.getUid()));
+	}
+	flaky.refresh(ec);
+	if (ec) {
+		fail("refresh() of uid 1234 failed: " + ec.message());
+	}
+	expectEqual("getHome() after a failed lookup", flaky.getHome(), "/home/flaky");
+
+	// By name
+	sago::UserFolders root("root", ec);
+	if (ec || root.getUid() != 0) {
+		fail("\"root\" has uid " + std::to_string(root.getUid()));
+	}
+	expectEqual("getHome() of \"root\"", root.getHome(), "/fake-root");
+	int before = lookups;
+	sago::UserFolders rootAgain("root");
+	if (lookups != before) {
+		fail("A cached user name was looked up again");
+	}
+	// Names come from the user name provider, not from the passwd database of the machine
+	expectEqual("getHome() of a user that only the provider knows", sago::UserFolders("sago-second-user").getHome(), secondHome);
+
+	sago::invalidateFolderCache();
+	if (sago::getUserFoldersCacheSize() != 0) {
+		fail("invalidateFolderCache() did not empty the cache");
+	}
+	sago::setPasswdProvider(sago::PasswdProvider());
+	sago::setUserNameProvider(sago::UserNameProvider());
+
+	// The real thing
+	sago::UserFolders self(static_cast<unsigned long>(getuid()), ec);
+	if (!ec) {
+		run_test(self.getDocumentsFolder());
+	}
+	sago::UserFolders realRoot("root", ec);
+	if (!ec && realRoot.getUid() != 0) {
+		fail("getpwnam_r() gave \"root\" uid " + std::to_string(realRoot.getUid()));
+	}
+#endif
+	return 0;
+}